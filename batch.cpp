@@ -0,0 +1,436 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "autotune.hpp"
+#include "field.hpp"
+#include "optimize.hpp"
+#include "raycast_kernel.hpp"
+#include "sweep.hpp"
+#include "trace.hpp"
+
+// Headless companion to pid_sim: everything here runs on pidsim_core alone,
+// no window or GL context needed.
+
+namespace {
+
+void PrintUsage() {
+    std::cerr <<
+        "usage: pid_batch <command> [options]\n"
+        "\n"
+        "commands:\n"
+        "  sweep     run every gain candidate against a scripted target, print CSV\n"
+        "  replay    re-run a trace recorded with 'pid_sim --record' and check it\n"
+        "            matches bit for bit (--trace file)\n"
+        "  autotune  relay experiment on both axes, print Ziegler-Nichols and\n"
+        "            Tyreus-Luyben PD gains, Kp backed off until they settle on\n"
+        "            the scenario; exits 1 unless at least one of them does\n"
+        "  optimize  CMA-ES search over all six gains for the lowest total ITAE\n"
+        "  scan      headless range scan (or Robot View depth); prints rays/s, or the\n"
+        "            columns as CSV with --csv 1\n"
+        "\n"
+        "scenario options:\n"
+        "  --start x,y        robot start position (default 0,0)\n"
+        "  --target x,y       point to chase (default 0.5,0.5)\n"
+        "  --duration s       simulated seconds per run (default 10)\n"
+        "  --dt s             physics/PID step (default 0.01)\n"
+        "  --latency s        actuation latency, rounded to ticks of --dt (default 0;\n"
+        "                     0.02 for autotune)\n"
+        "  --delay n          the same in ticks\n"
+        "  --threads n        worker threads (default: all cores)\n"
+        "  --backend type     controller arithmetic: float, double, or fixed for\n"
+        "                     the co-processor's Q16.16 (default float)\n"
+        "  --move-limit a     clamp translation outputs to [-a, a] (default none)\n"
+        "  --turn-limit a     clamp rotation outputs to [-a, a] (default none)\n"
+        "  --back-calc k      back-calculation anti-windup gain (default 0, off)\n"
+        "  --conditional 1    conditional-integration anti-windup\n"
+        "  --cascade o,i      cascaded control: position loops every o physics\n"
+        "                     ticks over velocity loops every i ticks; the swept\n"
+        "                     gains are the position loops'\n"
+        "  --move-vel p,i,d   translation velocity loop gains (default 20,0,0)\n"
+        "  --turn-vel p,i,d   rotation velocity loop gains (default 20,0,0)\n"
+        "  --profile v,a[,j]  follow a trapezoidal motion profile to the target,\n"
+        "                     S-curve if a jerk limit j is given\n"
+        "\n"
+        "sweep options:\n"
+        "  --move-p lo:hi:n   translation P grid, or a single value (same for -i, -d)\n"
+        "  --turn-p lo:hi:n   rotation P grid, or a single value (same for -i, -d)\n"
+        "  --gains file       explicit candidates instead of a grid, one\n"
+        "                     'moveP,moveI,moveD,turnP,turnI,turnD' per line\n"
+        "  --top n            only print the n best runs by total ITAE\n"
+        "  --skip-saturated 1 drop runs as soon as any output hits its limit\n"
+        "\n"
+        "autotune options:\n"
+        "  --relay h          relay acceleration amplitude (default 10)\n"
+        "  --hysteresis e     relay dead band (default 0)\n"
+        "  --backoff f        Kp factor after each failed check (default 0.7)\n"
+        "  --max-overshoot f  reject suggestions overshooting more (default 0.5)\n"
+        "\n"
+        "optimize options:\n"
+        "  --move-max p,i,d   upper bounds of the translation search box (default 20,5,20)\n"
+        "  --turn-max p,i,d   upper bounds of the rotation search box (default 20,5,20)\n"
+        "  --evals n          evaluation budget (default 3000)\n"
+        "  --pop n            candidates per generation (default 9)\n"
+        "  --sigma s          initial step, fraction of each range (default 0.3)\n"
+        "  --seed n           RNG seed (default 1)\n"
+        "\n"
+        "scan options:\n"
+        "  --pose x,y,r       robot pose (default 0,0,0)\n"
+        "  --rays n           columns per scan (default 750)\n"
+        "  --fov deg          field of view, 360 for a full ring (default 70)\n"
+        "  --repeat n         scans to time (default 1000)\n"
+        "  --field file       cast against segment/polygon geometry instead of the box\n"
+        "  --perpendicular 1  fisheye-corrected depth like the Robot View instead of\n"
+        "                     range along each ray; needs --fov under 180\n"
+        "  --csv 1            print 'column,depth,wall' for one scan instead\n";
+}
+
+// Minimal --flag value parser; every option here takes exactly one value.
+struct Args {
+    std::vector<std::pair<std::string, std::string>> options;
+
+    bool parse(int argc, char** argv, int first) {
+        for (int i = first; i < argc; i++) {
+            if (strncmp(argv[i], "--", 2) != 0 || i + 1 >= argc) {
+                std::cerr << "bad argument: " << argv[i] << "\n";
+                return false;
+            }
+            options.emplace_back(argv[i] + 2, argv[i + 1]);
+            i++;
+        }
+        return true;
+    }
+
+    const char* get(const char* name) const {
+        for (const auto& o : options) {
+            if (o.first == name) return o.second.c_str();
+        }
+        return nullptr;
+    }
+
+    float getFloat(const char* name, float fallback) const {
+        const char* v = get(name);
+        return v ? strtof(v, nullptr) : fallback;
+    }
+
+    int getInt(const char* name, int fallback) const {
+        const char* v = get(name);
+        return v ? atoi(v) : fallback;
+    }
+};
+
+bool ParsePair(const char* text, float& a, float& b) {
+    return text && sscanf(text, "%f,%f", &a, &b) == 2;
+}
+
+// "lo:hi:n" or a single value.
+void ParseRange(const char* text, float fallback, float& lo, float& hi, int& count) {
+    lo = hi = fallback;
+    count = 1;
+    if (!text) return;
+    if (sscanf(text, "%f:%f:%d", &lo, &hi, &count) != 3) {
+        lo = hi = strtof(text, nullptr);
+        count = 1;
+    }
+}
+
+bool ParseTriple(const char* text, float out[3]) {
+    return text && sscanf(text, "%f,%f,%f", &out[0], &out[1], &out[2]) == 3;
+}
+
+Scenario ScenarioFromArgs(const Args& args) {
+    Scenario s;
+    if (const char* v = args.get("start")) ParsePair(v, s.startX, s.startY);
+    if (const char* v = args.get("target")) ParsePair(v, s.targetX, s.targetY);
+    s.duration = args.getFloat("duration", s.duration);
+    s.dt = args.getFloat("dt", s.dt);
+    s.latency = args.getFloat("latency", s.latency);
+    if (args.get("delay")) s.latency = args.getInt("delay", 0) * s.dt;
+    if (const char* v = args.get("backend")) {
+        if (!parseBackend(v, s.backend)) std::cerr << "unknown backend " << v << ", using float\n";
+    }
+    s.moveLimit = args.getFloat("move-limit", s.moveLimit);
+    s.turnLimit = args.getFloat("turn-limit", s.turnLimit);
+    s.backCalculation = args.getFloat("back-calc", s.backCalculation);
+    s.conditionalIntegration = args.getInt("conditional", 0) != 0;
+    s.skipSaturated = args.getInt("skip-saturated", 0) != 0;
+    if (const char* v = args.get("cascade")) {
+        s.cascade.enabled = sscanf(v, "%d,%d", &s.cascade.outerEvery, &s.cascade.innerEvery) == 2;
+        if (!s.cascade.enabled) std::cerr << "--cascade wants outer,inner tick counts\n";
+    }
+    if (const char* v = args.get("move-vel")) ParseTriple(v, s.cascade.moveVelGains);
+    if (const char* v = args.get("turn-vel")) ParseTriple(v, s.cascade.turnVelGains);
+    if (const char* v = args.get("profile")) {
+        ProfileLimits& p = s.profile;
+        s.profiled = sscanf(v, "%f,%f,%f", &p.maxVel, &p.maxAccel, &p.maxJerk) >= 2;
+        if (!s.profiled) std::cerr << "--profile wants max velocity,acceleration[,jerk]\n";
+    }
+    return s;
+}
+
+std::vector<std::array<float, 3>> TriplesFromArgs(const Args& args, const char* prefix, const std::array<float, 3>& defaults) {
+    std::array<float, 3> lo, hi;
+    std::array<int, 3> counts;
+    const char* terms[3] = {"p", "i", "d"};
+    for (int k = 0; k < 3; k++) {
+        std::string name = std::string(prefix) + "-" + terms[k];
+        ParseRange(args.get(name.c_str()), defaults[k], lo[k], hi[k], counts[k]);
+    }
+    return makeTripleGrid(lo, hi, counts);
+}
+
+bool LoadGainList(const char* path, std::vector<Gains>& out) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "could not open " << path << "\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        Gains g;
+        if (sscanf(line.c_str(), "%f,%f,%f,%f,%f,%f", &g.move[0], &g.move[1], &g.move[2], &g.turn[0], &g.turn[1], &g.turn[2]) == 6) {
+            out.push_back(g);
+        }
+    }
+    return true;
+}
+
+void PrintAxis(const AxisMetrics& m) {
+    printf(",%g,%g,%g,%g,%g,%g", m.ise, m.iae, m.itae, m.overshoot, m.riseTime, m.settlingTime);
+}
+
+int RunSweepCommand(const Args& args) {
+    Scenario scenario = ScenarioFromArgs(args);
+
+    std::vector<Gains> candidates;
+    if (const char* path = args.get("gains")) {
+        if (!LoadGainList(path, candidates)) return 1;
+    } else {
+        candidates = makeGainGrid(
+            TriplesFromArgs(args, "move", {1.0f, 0.0f, 0.0f}),
+            TriplesFromArgs(args, "turn", {1.0f, 0.0f, 0.0f}));
+    }
+
+    ThreadPool pool(args.getInt("threads", std::thread::hardware_concurrency()));
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<RunResult> results = runSweep(candidates, scenario, pool);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    size_t skipped = results.size();
+    results.erase(std::remove_if(results.begin(), results.end(), [](const RunResult& r) { return r.saturated; }), results.end());
+    skipped -= results.size();
+
+    int top = args.getInt("top", 0);
+    if (top > 0) {
+        std::sort(results.begin(), results.end(), [](const RunResult& a, const RunResult& b) {
+            return runCost(a) < runCost(b);
+        });
+        if ((size_t)top < results.size()) results.resize(top);
+    }
+
+    printf("move_p,move_i,move_d,turn_p,turn_i,turn_d,diverged,"
+           "t_ise,t_iae,t_itae,t_overshoot,t_rise,t_settle,"
+           "r_ise,r_iae,r_itae,r_overshoot,r_rise,r_settle\n");
+    for (const RunResult& r : results) {
+        printf("%g,%g,%g,%g,%g,%g,%d", r.gains.move[0], r.gains.move[1], r.gains.move[2],
+               r.gains.turn[0], r.gains.turn[1], r.gains.turn[2], r.diverged ? 1 : 0);
+        PrintAxis(r.translation);
+        PrintAxis(r.rotation);
+        printf("\n");
+    }
+
+    fprintf(stderr, "%zu %s runs on %u threads in %.3f s (%.0f runs/s)\n", candidates.size(),
+            backendName(scenario.backend), pool.size(), seconds, candidates.size() / std::max(seconds, 1e-9));
+    if (skipped > 0) fprintf(stderr, "%zu runs skipped for saturating\n", skipped);
+    return 0;
+}
+
+int RunReplayCommand(const Args& args) {
+    const char* path = args.get("trace");
+    MappedFile file;
+    if (!path || !file.open(path)) {
+        std::cerr << "could not map trace " << (path ? path : "(none, use --trace)") << "\n";
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    ReplayResult r = replayTrace(file.data(), file.size());
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    printf("%llu ticks, %.1f s simulated, replayed in %.3f s (%.0fx real time)\n",
+           (unsigned long long)r.ticks, r.simSeconds, seconds, r.simSeconds / std::max(seconds, 1e-9));
+    if (!r.valid) printf("trace is malformed or truncated after tick %llu\n", (unsigned long long)r.ticks);
+    if (r.mismatches > 0) {
+        printf("%llu ticks diverged from the recording, first at tick %llu\n",
+               (unsigned long long)r.mismatches, (unsigned long long)r.firstMismatch);
+    } else {
+        printf("bit-exact\n");
+    }
+    return (r.valid && r.mismatches == 0) ? 0 : 1;
+}
+
+void PrintRelay(const char* name, const RelayResult& r) {
+    if (r.ok) {
+        printf("%s: Ku = %g, Pu = %g s, oscillation amplitude %g\n", name, r.ultimateGain, r.ultimatePeriod, r.amplitude);
+    } else {
+        printf("%s: no steady oscillation, relay test failed\n", name);
+    }
+}
+
+void PrintSuggestion(const char* rule, const TuningSuggestion& s) {
+    const RunResult& r = s.check;
+    printf("%s: %s, Kp at %.0f%% of the rule's\n", rule, s.usable ? "settles on the scenario" : s.problem, s.kpScale * 100.0f);
+    printf("  move P %g  I %g  D %g\n", s.move[0], s.move[1], s.move[2]);
+    printf("  turn P %g  I %g  D %g\n", s.turn[0], s.turn[1], s.turn[2]);
+    if (r.diverged || r.saturated) return;
+    printf("  translation: overshoot %.1f%%, rise %g s, settle %g s, ITAE %g\n",
+           r.translation.overshoot * 100.0f, r.translation.riseTime, r.translation.settlingTime, r.translation.itae);
+    printf("  rotation:    overshoot %.1f%%, rise %g s, settle %g s, ITAE %g\n",
+           r.rotation.overshoot * 100.0f, r.rotation.riseTime, r.rotation.settlingTime, r.rotation.itae);
+}
+
+int RunAutotuneCommand(const Args& args) {
+    Scenario scenario = ScenarioFromArgs(args);
+
+    RelayConfig config;
+    config.dt = scenario.dt;
+    config.relayAmplitude = args.getFloat("relay", config.relayAmplitude);
+    config.hysteresis = args.getFloat("hysteresis", config.hysteresis);
+    if (args.get("latency") || args.get("delay")) config.latency = scenario.latency;
+    config.backoff = args.getFloat("backoff", config.backoff);
+    config.maxOvershoot = args.getFloat("max-overshoot", config.maxOvershoot);
+
+    auto begin = std::chrono::steady_clock::now();
+    AutotuneResult t = autotune(config, scenario);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    PrintRelay("translation", t.translation);
+    PrintRelay("rotation", t.rotation);
+    printf("relay tests and checks took %.3f ms\n\n", seconds * 1000.0);
+    if (!t.translation.ok || !t.rotation.ok) return 1;
+
+    PrintSuggestion("Ziegler-Nichols", t.zieglerNichols);
+    PrintSuggestion("Tyreus-Luyben", t.tyreusLuyben);
+    return (t.zieglerNichols.usable || t.tyreusLuyben.usable) ? 0 : 1;
+}
+
+int RunOptimizeCommand(const Args& args) {
+    Scenario scenario = ScenarioFromArgs(args);
+
+    OptimizerConfig config;
+    if (const char* v = args.get("move-max")) ParseTriple(v, config.upper.move);
+    if (const char* v = args.get("turn-max")) ParseTriple(v, config.upper.turn);
+    config.maxEvaluations = args.getInt("evals", config.maxEvaluations);
+    config.populationSize = args.getInt("pop", config.populationSize);
+    config.initialSigma = args.getFloat("sigma", config.initialSigma);
+    config.seed = (unsigned)args.getInt("seed", (int)config.seed);
+
+    ThreadPool pool(args.getInt("threads", std::thread::hardware_concurrency()));
+
+    auto begin = std::chrono::steady_clock::now();
+    OptimizerResult r = optimizeGains(scenario, config, pool, [](int generation, int evaluations, float best) {
+        if (generation % 10 == 0) fprintf(stderr, "generation %d, %d evaluations, best %g\n", generation, evaluations, best);
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    fprintf(stderr, "%d evaluations (%d diverged) over %d generations in %.3f s\n",
+            r.evaluations, r.diverged, r.generations, seconds);
+    if (!std::isfinite(r.bestCost)) {
+        printf("every candidate diverged\n");
+        return 1;
+    }
+
+    const Gains& g = r.best.gains;
+    printf("best cost %g\n", r.bestCost);
+    printf("  move P %g  I %g  D %g\n", g.move[0], g.move[1], g.move[2]);
+    printf("  turn P %g  I %g  D %g\n", g.turn[0], g.turn[1], g.turn[2]);
+    printf("  translation: overshoot %.1f%%, rise %g s, settle %g s, ITAE %g\n",
+           r.best.translation.overshoot * 100.0f, r.best.translation.riseTime, r.best.translation.settlingTime, r.best.translation.itae);
+    printf("  rotation:    overshoot %.1f%%, rise %g s, settle %g s, ITAE %g\n",
+           r.best.rotation.overshoot * 100.0f, r.best.rotation.riseTime, r.best.rotation.settlingTime, r.best.rotation.itae);
+    return 0;
+}
+
+int RunScanCommand(const Args& args) {
+    RayScan scan{0.0f, 0.0f, 0.0f, 70.0f * (float)M_PI / 180.0f};
+    if (const char* v = args.get("pose")) sscanf(v, "%f,%f,%f", &scan.x, &scan.y, &scan.heading);
+    scan.fovRad = args.getFloat("fov", 70.0f) * (float)M_PI / 180.0f;
+    int rays = std::max(args.getInt("rays", 750), 1);
+    scan.perpendicular = args.getInt("perpendicular", 0) != 0;
+    if (scan.perpendicular && !(scan.fovRad < (float)M_PI)) {
+        std::cerr << "--perpendicular needs --fov under 180 degrees; rays past 90 would project backwards\n";
+        return 1;
+    }
+
+    Field field;
+    const char* fieldPath = args.get("field");
+    if (fieldPath) {
+        std::string error;
+        if (!field.load(fieldPath, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+    }
+
+    std::vector<float> depth(rays);
+    std::vector<uint8_t> wall(rays);
+    std::vector<int32_t> hit(rays);
+    auto castOnce = [&] {
+        if (fieldPath) castRays(scan, field, rays, depth.data(), hit.data());
+        else castRays(scan, rays, depth.data(), wall.data());
+    };
+
+    if (args.getInt("csv", 0)) {
+        castOnce();
+        printf("column,depth,%s\n", fieldPath ? "segment" : "wall");
+        for (int i = 0; i < rays; i++) {
+            if (fieldPath) printf("%d,%g,%d\n", i, depth[i], hit[i]);
+            else printf("%d,%g,%c\n", i, depth[i], wall[i] == WallX ? 'x' : 'y');
+        }
+        return 0;
+    }
+
+    int repeat = std::max(args.getInt("repeat", 1000), 1);
+    auto begin = std::chrono::steady_clock::now();
+    for (int k = 0; k < repeat; k++) castOnce();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    printf("%d scans of %d rays (%s) in %.3f s: %.0f scans/s, %.2f ns/ray\n", repeat, rays,
+           fieldPath ? "field grid" : castRaysPath(),
+           seconds, repeat / std::max(seconds, 1e-9), seconds * 1e9 / ((double)repeat * rays));
+    return 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    Args args;
+    if (!args.parse(argc, argv, 2)) {
+        PrintUsage();
+        return 1;
+    }
+
+    if (strcmp(argv[1], "sweep") == 0) return RunSweepCommand(args);
+    if (strcmp(argv[1], "replay") == 0) return RunReplayCommand(args);
+    if (strcmp(argv[1], "autotune") == 0) return RunAutotuneCommand(args);
+    if (strcmp(argv[1], "optimize") == 0) return RunOptimizeCommand(args);
+    if (strcmp(argv[1], "scan") == 0) return RunScanCommand(args);
+
+    PrintUsage();
+    return 1;
+}
@@ -0,0 +1,440 @@
+// pid_sim_bench: ns/op and throughput for the hot paths, as JSON on stdout so
+// two runs can be diffed or plotted. Build in Release (the default), and
+// with -DPIDSIM_NATIVE=ON to measure the AVX paths. "build" in the output
+// says which flags the run had; the *_scalar and per-object variants are
+// kept one lane wide, so they show what the batched paths buy.
+//
+//   ./pid_sim_bench [--filter substring] [--min-time seconds] > before.json
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "field.hpp"
+#include "fixed.hpp"
+#include "fleet.hpp"
+#include "fleet_sim.hpp"
+#include "motion_profile.hpp"
+#include "pid.hpp"
+#include "pid_bank.hpp"
+#include "raycast_kernel.hpp"
+#include "sim.hpp"
+#include "simd.hpp"
+#include "sweep.hpp"
+
+namespace {
+
+// Makes the compiler assume `value` is read, so the work producing it stays.
+template <typename T>
+inline void KeepAlive(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+struct BenchResult {
+    std::string name, variant;
+    long long items;      // per op (robots, rays, ...)
+    long long iterations;
+    double nsPerOp;
+    double itemsPerSecond;
+};
+
+struct Bench {
+    const char* filter = nullptr;
+    double minTime = 0.2;
+    std::vector<BenchResult> results;
+    // Batched paths that must match their one-lane reference bit for bit.
+    std::vector<std::pair<std::string, bool>> checks;
+
+    bool allExact() const {
+        for (const auto& c : checks) {
+            if (!c.second) return false;
+        }
+        return true;
+    }
+
+    bool wanted(const std::string& name, const std::string& variant) const {
+        return !filter || (name + "/" + variant).find(filter) != std::string::npos;
+    }
+
+    // Times `op` (one call = one op over `items` items). Iterations double
+    // until a batch takes minTime, then the best of five such batches counts,
+    // which is the least disturbed by whatever else the machine is doing.
+    template <typename Op>
+    void run(const std::string& name, const std::string& variant, long long items, Op op) {
+        if (!wanted(name, variant)) return;
+
+        using Clock = std::chrono::steady_clock;
+        auto timeBatch = [&](long long n) {
+            auto start = Clock::now();
+            for (long long i = 0; i < n; i++) op();
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        };
+
+        long long n = 1;
+        while (timeBatch(n) < minTime && n < (1LL << 40)) n *= 2;
+
+        double best = 1e300;
+        for (int rep = 0; rep < 5; rep++) best = std::min(best, timeBatch(n));
+
+        double nsPerOp = best * 1e9 / n;
+        results.push_back({name, variant, items, n, nsPerOp, items * 1e9 / nsPerOp});
+        fprintf(stderr, "%-22s %-14s %12.2f ns/op\n", name.c_str(), variant.c_str(), nsPerOp);
+    }
+
+    void print() const {
+        // The core's flags can differ from this file's: PIDSIM_NATIVE only
+        // applies to pidsim_core.
+        CoreBuild core = coreBuild();
+        auto flag = [](bool on) { return on ? "true" : "false"; };
+        printf("{\n");
+        printf("  \"build\": {\"pidsim_native\": %s, \"core_sse2\": %s, \"core_avx\": %s, \"core_avx2\": %s, "
+               "\"core_fma\": %s, \"bench_avx2\": %s, \"compiler\": \"%s\"},\n",
+               flag(core.native), flag(core.sse2), flag(core.avx), flag(core.avx2), flag(core.fma),
+#if defined(__AVX2__)
+               flag(true),
+#else
+               flag(false),
+#endif
+               __VERSION__);
+        printf("  \"fleet_simd\": \"%s\",\n", Fleet::simdPath());
+        printf("  \"raycast_simd\": \"%s\",\n", castRaysPath());
+        printf("  \"exact\": {");
+        for (size_t i = 0; i < checks.size(); i++) {
+            printf("%s\"%s\": %s", i ? ", " : "", checks[i].first.c_str(), flag(checks[i].second));
+        }
+        printf("},\n");
+        printf("  \"results\": [\n");
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult& r = results[i];
+            printf("    {\"name\": \"%s\", \"variant\": \"%s\", \"items\": %lld, \"iterations\": %lld, "
+                   "\"ns_per_op\": %.3f, \"ns_per_item\": %.4f, \"items_per_sec\": %.1f}%s\n",
+                   r.name.c_str(), r.variant.c_str(), r.items, r.iterations,
+                   r.nsPerOp, r.nsPerOp / r.items, r.itemsPerSecond, (i + 1 < results.size()) ? "," : "");
+        }
+        printf("  ]\n}\n");
+    }
+};
+
+// The per-object baselines, kept one lane wide like the core's references.
+PIDSIM_SCALAR_REFERENCE void StepObjects(std::vector<PID>& pids, const float* errors, float* out) {
+    PIDSIM_NO_VECTORIZE_LOOP
+    for (size_t k = 0; k < pids.size(); k++) out[k] = pids[k].calculate_error(errors[k], 0.01f);
+}
+
+PIDSIM_SCALAR_REFERENCE void StepObjects(std::vector<SwerveDrive>& robots, const float* ax, const float* ay, const float* ar, float sign) {
+    PIDSIM_NO_VECTORIZE_LOOP
+    for (size_t i = 0; i < robots.size(); i++) robots[i].updatePose(sign * ax[i], sign * ay[i], sign * ar[i], 0.01f);
+}
+
+std::vector<float> RandomFloats(size_t n, float lo, float hi, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(lo, hi);
+    std::vector<float> v(n);
+    for (float& f : v) f = dist(rng);
+    return v;
+}
+
+// One controller in T, fed errors converted up front so only the PID's own
+// arithmetic is timed.
+template <typename T>
+void BenchPIDType(Bench& bench, const char* variant, const std::vector<float>& errors) {
+    std::vector<T> e(errors.size());
+    for (size_t k = 0; k < errors.size(); k++) e[k] = T(errors[k]);
+    BasicPID<T> pid(T(2.0f), T(0.5f), T(0.3f));
+    T dt(0.01f);
+    size_t i = 0;
+    bench.run("pid_calculate_error", variant, 1, [&] {
+        T out = pid.calculate_error(e[i++ & 1023], dt);
+        KeepAlive(out);
+    });
+}
+
+void BenchPID(Bench& bench) {
+    // Cycle through precomputed errors so nothing folds to a constant. They
+    // average out to about zero, so the integrators stay small.
+    std::vector<float> errors = RandomFloats(1024, -1.0f, 1.0f, 1);
+    BenchPIDType<float>(bench, "scalar", errors);
+    BenchPIDType<double>(bench, "double", errors);
+    BenchPIDType<Fixed>(bench, "fixed_q16", errors);
+
+    // Same again with limits that bind now and then, and both anti-windups.
+    PID pid(2.0f, 0.5f, 0.3f);
+    pid.setLimits(-1.5f, 1.5f);
+    pid.back_calc = 0.5f;
+    pid.conditional_integration = true;
+    size_t i = 0;
+    bench.run("pid_calculate_error", "scalar_clamped", 1, [&] {
+        float out = pid.calculate_error(errors[i++ & 1023], 0.01f);
+        KeepAlive(out);
+    });
+}
+
+void BenchPIDBank(Bench& bench) {
+    // Thousands of controllers with their own gains, one error each per
+    // step. The errors flip sign every step, so the integrators stay bounded.
+    const size_t count = 4096;
+    std::vector<float> gains = RandomFloats(count * 3, 0.0f, 2.0f, 8);
+    std::vector<float> errors = RandomFloats(count, -1.0f, 1.0f, 9);
+    std::vector<float> negated(count), out(count);
+    for (size_t k = 0; k < count; k++) negated[k] = -errors[k];
+
+    std::vector<PID> objects;
+    PIDBank bank;
+    for (size_t k = 0; k < count; k++) {
+        objects.emplace_back(gains[3 * k], gains[3 * k + 1], gains[3 * k + 2]);
+        bank.add(gains[3 * k], gains[3 * k + 1], gains[3 * k + 2]);
+    }
+
+    bool flip = false;
+    bench.run("pid_bank_4096", "pid_objects", count, [&] {
+        StepObjects(objects, flip ? negated.data() : errors.data(), out.data());
+        flip = !flip;
+        KeepAlive(out[0]);
+    });
+    bench.run("pid_bank_4096", "bank_scalar", count, [&] {
+        bank.stepScalar(flip ? negated.data() : errors.data(), 0.01f, out.data());
+        flip = !flip;
+        KeepAlive(out[0]);
+    });
+    bench.run("pid_bank_4096", std::string("bank_auto_") + PIDBank::simdPath(), count, [&] {
+        bank.step(flip ? negated.data() : errors.data(), 0.01f, out.data());
+        flip = !flip;
+        KeepAlive(out[0]);
+    });
+}
+
+void BenchUpdatePose(Bench& bench) {
+    const size_t robots = 1024;
+    std::vector<float> ax = RandomFloats(robots, -1.0f, 1.0f, 2);
+    std::vector<float> ay = RandomFloats(robots, -1.0f, 1.0f, 3);
+    std::vector<float> ar = RandomFloats(robots, -1.0f, 1.0f, 4);
+
+    // Accelerations are tiny and alternate in sign, so poses stay bounded
+    // however many iterations the timer asks for.
+    float sign = 1.0f;
+    std::vector<SwerveDrive> aos(robots, SwerveDrive(0.0f, 0.0f));
+    bench.run("update_pose", "aos_scalar", robots, [&] {
+        StepObjects(aos, ax.data(), ay.data(), ar.data(), sign);
+        sign = -sign;
+        KeepAlive(aos[0].x);
+    });
+
+    Fleet fleet(robots);
+    std::vector<float> bx = ax, by = ay, br = ar;
+    for (size_t i = 0; i < robots; i++) {
+        bx[i] = -ax[i];
+        by[i] = -ay[i];
+        br[i] = -ar[i];
+    }
+
+    // Before timing anything: the batched step has to track the one-lane
+    // loop bit for bit, here over 1000 steps of full-size pushes. 1021
+    // robots leaves a ragged tail after the last full vector.
+    if (bench.wanted("update_pose", "exact")) {
+        std::vector<float> push = RandomFloats(3 * 1021, -1000.0f, 1000.0f, 10);
+        Fleet batched(1021, 0.1f, -0.2f), reference(1021, 0.1f, -0.2f);
+        for (int step = 0; step < 1000; step++) {
+            std::rotate(push.begin(), push.begin() + 7, push.end());
+            batched.updatePose(push.data(), push.data() + 1021, push.data() + 2042, 0.01f);
+            reference.updatePoseScalar(push.data(), push.data() + 1021, push.data() + 2042, 0.01f);
+        }
+        bool exact = true;
+        for (auto member : {&Fleet::x, &Fleet::y, &Fleet::r, &Fleet::x_back, &Fleet::y_back, &Fleet::r_back}) {
+            exact = exact && memcmp((batched.*member).data(), (reference.*member).data(), 1021 * sizeof(float)) == 0;
+        }
+        bench.checks.emplace_back("fleet_update_pose", exact);
+        if (!exact) fprintf(stderr, "Fleet::updatePose doesn't match updatePoseScalar\n");
+    }
+
+    bool flip = false;
+    bench.run("update_pose", "fleet_scalar", robots, [&] {
+        fleet.updatePoseScalar(flip ? bx.data() : ax.data(), flip ? by.data() : ay.data(), flip ? br.data() : ar.data(), 0.01f);
+        flip = !flip;
+        KeepAlive(fleet.x[0]);
+    });
+    bench.run("update_pose", std::string("fleet_auto_") + Fleet::simdPath(), robots, [&] {
+        fleet.updatePose(flip ? bx.data() : ax.data(), flip ? by.data() : ay.data(), flip ? br.data() : ar.data(), 0.01f);
+        flip = !flip;
+        KeepAlive(fleet.x[0]);
+    });
+}
+
+void BenchRaycast(Bench& bench) {
+    std::vector<float> depth(4096);
+    std::vector<uint8_t> wall(4096);
+    std::vector<int32_t> hit(4096);
+    // Perpendicular depth, as the Robot View asks for.
+    RayScan scan{0.2f, -0.3f, 0.4f, 70.0f * 3.14159265f / 180.0f, 1.0f, 1.0f, true};
+
+    // A box plus a scatter of short segments, roughly a busy field file.
+    Field field = Field::box(1.0f, 1.0f);
+    std::vector<float> pts = RandomFloats(200 * 4, -0.9f, 0.9f, 5);
+    for (size_t i = 0; i < pts.size(); i += 4) {
+        field.addSegment(pts[i], pts[i + 1], pts[i] + 0.1f * pts[i + 2], pts[i + 1] + 0.1f * pts[i + 3], 1.0f, 1.0f, 1.0f);
+    }
+    field.build();
+
+    for (int rays : {64, 256, 750, 2048}) {
+        std::string name = "cast_rays_" + std::to_string(rays);
+        bench.run(name, "box_scalar", rays, [&] {
+            castRaysScalar(scan, rays, depth.data(), wall.data());
+            KeepAlive(depth[0]);
+        });
+        bench.run(name, std::string("box_auto_") + castRaysPath(), rays, [&] {
+            castRays(scan, rays, depth.data(), wall.data());
+            KeepAlive(depth[0]);
+        });
+        bench.run(name, "field_grid", rays, [&] {
+            castRays(scan, field, rays, depth.data(), hit.data());
+            KeepAlive(depth[0]);
+        });
+    }
+
+    // Same rays one at a time, grid walk vs testing every segment.
+    std::vector<float> angles = RandomFloats(1024, 0.0f, 6.2831853f, 6);
+    size_t i = 0;
+    bench.run("field_raycast", "grid", 1, [&] {
+        float a = angles[i++ & 1023];
+        FieldHit h = field.raycast(scan.x, scan.y, cosf(a), sinf(a));
+        KeepAlive(h.t);
+    });
+    bench.run("field_raycast", "brute_force", 1, [&] {
+        float a = angles[i++ & 1023];
+        FieldHit h = field.raycastBruteForce(scan.x, scan.y, cosf(a), sinf(a));
+        KeepAlive(h.t);
+    });
+}
+
+void BenchProfile(Bench& bench) {
+    ProfileLimits trapezoid;
+    ProfileLimits scurve;
+    scurve.maxJerk = 40.0f;
+    std::vector<float> distances = RandomFloats(1024, 0.05f, 2.5f, 8);
+    std::vector<float> times = RandomFloats(1024, 0.0f, 1.5f, 9);
+
+    // Building a table for a click, vs reading one sample of it per tick.
+    MotionProfile profile;
+    size_t i = 0;
+    bench.run("motion_profile", "build_trapezoid", 1, [&] {
+        profile.build(distances[i++ & 1023], trapezoid, 0.01f);
+        KeepAlive(profile.table().back().pos);
+    });
+    bench.run("motion_profile", "build_scurve", 1, [&] {
+        profile.build(distances[i++ & 1023], scurve, 0.01f);
+        KeepAlive(profile.table().back().pos);
+    });
+    profile.build(1.5f, scurve, 0.01f);
+    bench.run("motion_profile", "sample", 1, [&] {
+        ProfileSample s = profile.sample(times[i++ & 1023]);
+        KeepAlive(s.pos);
+    });
+}
+
+void BenchTick(Bench& bench) {
+    const float move[3] = {2.0f, 0.1f, 0.5f};
+    const float turn[3] = {3.0f, 0.0f, 0.2f};
+    std::vector<float> targets = RandomFloats(2048, -0.8f, 0.8f, 7);
+
+    // What SimThread does per tick: errors, three PIDs and the Verlet step.
+    // The target hops around so the robot keeps moving.
+    Simulation sim(move, turn);
+    size_t i = 0;
+    bench.run("sim_tick", "single", 1, [&] {
+        size_t k = (i++ >> 6) & 1023;
+        SimError e = sim.step(targets[2 * k], targets[2 * k + 1], 0.01f);
+        KeepAlive(e.dx);
+    });
+
+    SimTerms terms;
+    i = 0;
+    bench.run("sim_tick", "single_terms", 1, [&] {
+        size_t k = (i++ >> 6) & 1023;
+        SimError e = sim.step(targets[2 * k], targets[2 * k + 1], 0.01f, &terms);
+        KeepAlive(e.dx);
+        KeepAlive(terms.x.p);
+    });
+
+    // Same, following a motion profile to each target: one table build per
+    // hop, then a lookup and the feedforward every tick.
+    ProfileFollower follower;
+    follower.limits.maxJerk = 40.0f;
+    i = 0;
+    bench.run("sim_tick", "single_profiled", 1, [&] {
+        size_t k = (i++ >> 6) & 1023;
+        Reference ref = follower.next(targets[2 * k], targets[2 * k + 1], sim.robot, 0.01f);
+        SimError e = sim.step(targets[2 * k], targets[2 * k + 1], 0.01f, nullptr, &ref);
+        KeepAlive(e.dx);
+    });
+
+    // A whole sweep run (10 s at 100 Hz) per controller backend.
+    for (PIDBackend backend : {PIDBackend::Float, PIDBackend::Double, PIDBackend::Fixed}) {
+        Scenario scenario;
+        scenario.backend = backend;
+        Gains gains = {{move[0], move[1], move[2]}, {turn[0], turn[1], turn[2]}};
+        bench.run("evaluate_gains", backendName(backend), 1000, [&] {
+            RunResult r = evaluateGains(gains, scenario);
+            KeepAlive(r.translation.itae);
+        });
+    }
+
+    // One simulated second at 1 kHz physics under a 50 Hz position loop,
+    // for a few velocity loop rates: what raising the inner rate costs.
+    for (int innerEvery : {1, 4, 10}) {
+        CascadeConfig cascade;
+        cascade.enabled = true;
+        cascade.outerEvery = 20;
+        cascade.innerEvery = innerEvery;
+        for (float& g : cascade.moveVelGains) g *= 10.0f;
+        for (float& g : cascade.turnVelGains) g *= 10.0f;
+        std::string variant = "inner_" + std::to_string(1000 / innerEvery) + "hz";
+        bench.run("cascade_1s", variant, 1000, [&] {
+            Simulation cascaded(move, turn);
+            cascaded.setCascade(cascade);
+            SimError e{0.0f, 0.0f, 0.0f};
+            for (int t = 0; t < 1000; t++) e = cascaded.step(targets[2 * (t >> 6)], targets[2 * (t >> 6) + 1], 0.001f);
+            KeepAlive(e.dx);
+        });
+    }
+
+    FleetSim fleet(1024, move, turn, 0.2f, 1);
+    i = 0;
+    bench.run("sim_tick", "fleet_1024", 1024, [&] {
+        size_t k = (i++ >> 6) & 1023;
+        fleet.step(targets[2 * k], targets[2 * k + 1], 0.01f);
+        KeepAlive(fleet.fleet.x[0]);
+    });
+}
+
+}
+
+int main(int argc, char** argv) {
+    Bench bench;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) bench.filter = argv[++i];
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) bench.minTime = atof(argv[++i]);
+        else {
+            fprintf(stderr, "usage: pid_sim_bench [--filter substring] [--min-time seconds]\n");
+            return 1;
+        }
+    }
+
+    BenchPID(bench);
+    BenchPIDBank(bench);
+    BenchUpdatePose(bench);
+    BenchRaycast(bench);
+    BenchProfile(bench);
+    BenchTick(bench);
+
+    bench.print();
+    return bench.allExact() ? 0 : 1;
+}
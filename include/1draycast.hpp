@@ -5,52 +5,117 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <vector>
 #include <cmath>
+#include <vector>
+#include "field.hpp"
+#include "raycast_kernel.hpp"
+#include "shader_program.hpp"
+#include "sim.hpp"
 
 class Raycaster {
 private:
     GLuint VAO, VBO;
+    // Attribute-less VAO for drawGpu's full-screen triangle; core profile
+    // still wants one bound.
+    GLuint emptyVAO;
     int numRays;
     const float limitX = 1.0f;
     const float limitY = 1.0f;
     float focalLength = 0.1f; 
     float fovDegrees = 70.0f; 
 
+    // Vertices go straight into a ring in the VBO, mapped unsynchronized so
+    // we never wait on the GPU. Room for a few frames of columns + cursor;
+    // when it wraps, the storage is orphaned and the driver hands us fresh
+    // memory while earlier draws still read the old one.
+    static constexpr int kFloatsPerVertex = 6;
+    static constexpr int kFloatsPerQuad = 6 * kFloatsPerVertex;
+    static constexpr int kRingFrames = 3;
+    GLsizeiptr ringBytes;
+    GLintptr ringOffset = 0;
+
+    // Where the quads go when glMapBufferRange fails; finishQuads then
+    // uploads them with glBufferSubData instead.
+    std::vector<float> staging;
+    bool mapped = false;
+    GLintptr mappedOffset = 0;
+    GLsizeiptr mappedBytes = 0;
+
+    // Per-column output of castRays, reused every frame.
+    std::vector<float> depths;
+    std::vector<uint8_t> walls;
+    std::vector<int32_t> hits;
+
+    // Custom geometry to look at instead of the plain box, if any.
+    const Field* field = nullptr;
+
+    // drawGpu's uniforms in the GPU raycast program, resolved once here.
+    GLint poseLoc, limitsLoc, originLoc, viewportLoc, fovLoc, focalLoc, columnsLoc;
+
 public:
-    Raycaster(int rays) : numRays(rays) {
+    // `gpuProgram` is the one drawGpu will be given (CreateRaycastProgram).
+    Raycaster(int rays, const ShaderProgram& gpuProgram)
+        : numRays(rays), depths(rays), walls(rays), hits(rays),
+          poseLoc(gpuProgram.uniform("uPose")), limitsLoc(gpuProgram.uniform("uLimits")),
+          originLoc(gpuProgram.uniform("uOrigin")), viewportLoc(gpuProgram.uniform("uViewport")),
+          fovLoc(gpuProgram.uniform("uFov")), focalLoc(gpuProgram.uniform("uFocal")),
+          columnsLoc(gpuProgram.uniform("uColumns")) {
+        ringBytes = (GLsizeiptr)(numRays + 1) * kFloatsPerQuad * sizeof(float) * kRingFrames;
+
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, ringBytes, nullptr, GL_STREAM_DRAW);
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+
+        glGenVertexArrays(1, &emptyVAO);
     }
 
-    void updateAndDraw(GLuint shader, float robotX, float robotY, float robotR) {
-        std::vector<float> vertices;
-        vertices.reserve(numRays * 6 * 6);
+    ~Raycaster() {
+        glDeleteBuffers(1, &VBO);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteVertexArrays(1, &emptyVAO);
+    }
 
-        float fovRad = glm::radians(fovDegrees);
-        float startAngle = (robotR + 1.57079f) - (fovRad / 2.0f) ;
+    Raycaster(const Raycaster&) = delete;
+    Raycaster& operator=(const Raycaster&) = delete;
 
-        for (int i = 0; i < numRays; i++) {
-            float rayAngle = startAngle + ((float)i / (float)numRays) * fovRad;
-            float dirX = cos(rayAngle);
-            float dirY = sin(rayAngle);
+    // The field must outlive the raycaster; null goes back to the box.
+    void setField(const Field* f) { field = f; }
+    bool hasField() const { return field != nullptr; }
 
-            float tX = (dirX > 0) ? (limitX - robotX) / dirX : (-limitX - robotX) / dirX ;
-            float tY = (dirY > 0) ? (limitY - robotY) / dirY : (-limitY - robotY) / dirY;
+    void updateAndDraw(const ShaderProgram& shader, float robotX, float robotY, float robotR) {
+        RayScan scan{robotX, robotY, robotR, glm::radians(fovDegrees), limitX, limitY, true};
+        if (field) {
+            castRays(scan, *field, numRays, depths.data(), hits.data());
+        } else {
+            castRays(scan, numRays, depths.data(), walls.data());
+        }
 
-            float dist;
-            glm::vec3 color;
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
-            if (tX < tY) {
-                dist = tX;
-                color = glm::vec3(0.7f, 0.3f, 0.3f); 
+        GLint firstVertex;
+        float* vertices = mapQuads(numRays, firstVertex);
+
+        for (int i = 0; i < numRays; i++) {
+            float dist = depths[i];
+            glm::vec3 color;
+            if (field) {
+                // A miss has infinite depth and so a zero-height column.
+                const Segment* s = (hits[i] >= 0) ? &field->segments[hits[i]] : nullptr;
+                color = s ? glm::vec3(s->r, s->g, s->b) : glm::vec3(0.0f);
             } else {
-                dist = tY;
-                color = glm::vec3(0.3f, 0.4f, 0.6f); 
+                color = (walls[i] == WallX) ? glm::vec3(0.7f, 0.3f, 0.3f) : glm::vec3(0.3f, 0.4f, 0.6f);
             }
 
-            dist *= cos(rayAngle - (robotR + 1.57079f) );
-
             float h = focalLength / (dist + 0.001f); 
             
             if (h > 1.0f) h = 1.0f;
@@ -61,57 +126,97 @@ public:
             addQuad(vertices, xLeft, xRight, h, color);
         }
 
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STREAM_DRAW);
+        if (!finishQuads()) return;
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-
-        glUseProgram(shader);
-        glm::mat4 ident = glm::mat4(1.0f);
-        glUniformMatrix4fv(glGetUniformLocation(shader, "model"), 1, GL_FALSE, &ident[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(shader, "view"), 1, GL_FALSE, &ident[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(shader, "projection"), 1, GL_FALSE, &ident[0][0]);
+        shader.use();
+        glDrawArrays(GL_TRIANGLES, firstVertex, numRays * 6);
+    }
 
-        glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 6);
+    // Same picture as updateAndDraw, but the fragment shader from
+    // CreateRaycastProgram does the wall test per pixel column. Only the pose
+    // goes up as uniforms, and there is one column per pixel of `width`.
+    // (originX, originY) is the viewport's corner in the framebuffer.
+    void drawGpu(const ShaderProgram& shader, float robotX, float robotY, float robotR, int originX, int originY, int width, int height) {
+        shader.use();
+        glUniform3f(poseLoc, robotX, robotY, robotR);
+        glUniform2f(limitsLoc, limitX, limitY);
+        glUniform2f(originLoc, (float)originX, (float)originY);
+        glUniform2f(viewportLoc, (float)width, (float)height);
+        glUniform1f(fovLoc, glm::radians(fovDegrees));
+        glUniform1f(focalLoc, focalLength);
+        glUniform1f(columnsLoc, (float)width);
+
+        glBindVertexArray(emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
     }
 
 
-    void drawCursor(GLuint shader, float robotX, float robotY, float robotR, float mouseX, float mouseY) {
+    void drawCursor(const ShaderProgram& shader, float robotX, float robotY, float robotR, float mouseX, float mouseY) {
         float dx = mouseX - robotX;
         float dy = mouseY - robotY;
         float dist = sqrt(dx * dx + dy * dy);
         float angleToMouse = atan2(dy, dx);
         
-        float relativeAngle = angleToMouse - (robotR + 1.5708f);
-        
-        while (relativeAngle > M_PI) relativeAngle -= 2.0f * M_PI;
-        while (relativeAngle < -M_PI) relativeAngle += 2.0f * M_PI;
+        // NaN once the heading is inf, which skips the sprite below.
+        float relativeAngle = wrapAngle(angleToMouse - (robotR + 1.5708f));
 
         float fovRad = glm::radians(fovDegrees);
-        if (abs(relativeAngle) < fovRad / 2.0f && (dist >= 0.1)) {
+        if (std::fabs(relativeAngle) < fovRad / 2.0f && (dist >= 0.1)) {
             float screenX = relativeAngle / (fovRad / 2.0f);
             
             dist *= cos(relativeAngle); 
             float h = (focalLength / dist) * 0.5f; 
             float w = h; 
 
-            std::vector<float> spriteVerts;
+            glBindVertexArray(VAO);
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+            GLint firstVertex;
+            float* spriteVerts = mapQuads(1, firstVertex);
             glm::vec3 white(1.0f, 1.0f, 1.0f);
             addQuad(spriteVerts, screenX - w, screenX + w, h, white);
+            if (!finishQuads()) return;
 
-            glBindVertexArray(VAO);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO);
-            glBufferData(GL_ARRAY_BUFFER, spriteVerts.size() * sizeof(float), spriteVerts.data(), GL_DYNAMIC_DRAW);
-            glDrawArrays(GL_TRIANGLES, 0, spriteVerts.size() / 6);
+            shader.use();
+            glDrawArrays(GL_TRIANGLES, firstVertex, 6);
         }
     }
 
 private:
-    void addQuad(std::vector<float>& buffer, float xL, float xR, float h, glm::vec3 c) {
+    // Reserves room for `quads` quads in the ring (VBO must be bound) and maps
+    // it for writing. If the map fails (lost context, driver limits) the
+    // quads are written to `staging` instead. Call finishQuads before drawing.
+    float* mapQuads(int quads, GLint& firstVertex) {
+        GLsizeiptr bytes = (GLsizeiptr)quads * kFloatsPerQuad * sizeof(float);
+        if (ringOffset + bytes > ringBytes) {
+            glBufferData(GL_ARRAY_BUFFER, ringBytes, nullptr, GL_STREAM_DRAW);
+            ringOffset = 0;
+        }
+
+        void* p = glMapBufferRange(GL_ARRAY_BUFFER, ringOffset, bytes,
+                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        firstVertex = (GLint)(ringOffset / (kFloatsPerVertex * sizeof(float)));
+        mapped = p != nullptr;
+        mappedOffset = ringOffset;
+        mappedBytes = bytes;
+        ringOffset += bytes;
+        if (mapped) return (float*)p;
+
+        staging.resize((size_t)quads * kFloatsPerQuad);
+        return staging.data();
+    }
+
+    // Unmaps, or uploads the staged quads. False if the buffer contents were
+    // lost on unmap, in which case skip this draw; the next frame rewrites it.
+    bool finishQuads() {
+        if (mapped) return glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+        glBufferSubData(GL_ARRAY_BUFFER, mappedOffset, mappedBytes, staging.data());
+        return true;
+    }
+
+    // Writes one column quad and advances `out` past it.
+    void addQuad(float*& out, float xL, float xR, float h, glm::vec3 c) {
         float quadVertices[] = {
             xL,  h, 0.0f, c.r, c.g, c.b,
             xL, -h, 0.0f, c.r, c.g, c.b,
@@ -121,7 +226,7 @@ private:
             xR, -h, 0.0f, c.r, c.g, c.b,
             xR,  h, 0.0f, c.r, c.g, c.b
         };
-        buffer.insert(buffer.end(), std::begin(quadVertices), std::end(quadVertices));
+        for (float v : quadVertices) *out++ = v;
     }
 };
 
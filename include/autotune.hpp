@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cmath>
+#include "sweep.hpp"
+
+// Åström–Hägglund relay auto-tuning against the SwerveDrive plant. Instead of
+// a PID, a relay bangs the acceleration between +h and -h on the sign of the
+// error. The loop settles into a limit cycle whose amplitude a and period Pu
+// give the ultimate gain Ku = 4h / (pi * a). Classic tuning rules turn
+// (Ku, Pu) into starting P/I/D gains.
+//
+// The bare plant has no lag of its own, so without actuation latency Ku
+// only reflects the step size (thousands, swinging wildly with dt). The
+// latency is modelled in the relay test and in the scenario every
+// suggestion is checked on, so both see the same plant.
+//
+// The plant integrates (acceleration in, position out), so an integral term
+// makes every step overshoot: the error has to integrate back to zero. Past
+// the target, the bearing the rotation loop faces swings round by pi. So the
+// suggestions take Kp and Td from each rule and leave I at 0, then back Kp
+// off until the check passes; check `usable`.
+
+enum class RelayAxis { Translation, Rotation };
+
+struct RelayConfig {
+    float dt = 0.01f;            // same step the PID will run at
+    float relayAmplitude = 10.0f; // h, in the plant's acceleration units
+    float hysteresis = 0.0f;     // error band where the relay holds its state
+    float setpoint = 0.25f;      // distance (or angle) to oscillate around
+    // Actuation latency to model (bus + motor controller), rounded to whole
+    // ticks of dt. This is what sets Ku and Pu, so keep it realistic.
+    float latency = 0.02f;
+    int settleCycles = 3;        // cycles skipped while the oscillation builds
+    int measureCycles = 5;       // cycles averaged for Ku and Pu
+    int maxSteps = 100000;
+    // A suggestion overshooting more than this on the scenario is rejected.
+    float maxOvershoot = 0.5f;
+    // Each failed check multiplies Kp by `backoff`, up to maxBackoffs times.
+    float backoff = 0.7f;
+    int maxBackoffs = 15;
+    // P, I, D ceilings a suggestion also has to fit under, e.g. slider ranges.
+    float maxGain[3] = {INFINITY, INFINITY, INFINITY};
+
+    int delaySteps() const { return (int)std::lround(latency / dt); }
+};
+
+struct RelayResult {
+    bool ok = false;       // false if no steady oscillation showed up
+    float ultimateGain = 0.0f;
+    float ultimatePeriod = 0.0f; // seconds
+    float amplitude = 0.0f;      // of the error, same units as the setpoint
+};
+
+// One tuning rule's gains and how they did on the scenario.
+struct TuningSuggestion {
+    // P, I, D for pid_x/pid_y (move) and pid_r (turn).
+    float move[3] = {0.0f, 0.0f, 0.0f};
+    float turn[3] = {0.0f, 0.0f, 0.0f};
+    RunResult check;
+    float kpScale = 1.0f; // how much of the rule's Kp is left after backing off
+    bool usable = false;
+    const char* problem = "relay test failed"; // why not, when !usable
+};
+
+struct AutotuneResult {
+    RelayResult translation, rotation;
+    TuningSuggestion zieglerNichols, tyreusLuyben;
+};
+
+RelayResult relayExperiment(RelayAxis axis, const RelayConfig& config);
+
+// Classic Ziegler–Nichols PID: fast, expect roughly 25-50% overshoot.
+void zieglerNicholsGains(float ku, float pu, float out[3]);
+// Tyreus–Luyben: much less aggressive, better as a first guess.
+void tyreusLuybenGains(float ku, float pu, float out[3]);
+
+// Runs the relay test on both axes, fills in both tuning rules and scores
+// each on `scenario` with config.latency in place of its own (its dt should
+// match config.dt). A suggestion is only usable if it fits config.maxGain,
+// neither diverges nor saturates, both axes settle, and neither overshoots
+// past config.maxOvershoot.
+AutotuneResult autotune(const RelayConfig& config, const Scenario& scenario);
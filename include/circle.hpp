@@ -7,17 +7,20 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <cmath>
+#include "shader_program.hpp"
 
 class CircleIndicator {
 private:
     GLuint VAO, VBO, EBO;
     int vertexCount;
     float radius = 0.02f; 
+    GLint modelLoc; // in the map program, resolved once here
 
 public:
     float x, y;
 
-    CircleIndicator(float startX, float startY) : x(startX), y(startY) {
+    CircleIndicator(const ShaderProgram& shaderProgram, float startX, float startY)
+        : modelLoc(shaderProgram.uniform("model")), x(startX), y(startY) {
         std::vector<float> vertices;
         std::vector<unsigned int> indices;
         int segments = 50; 
@@ -59,21 +62,11 @@ public:
         glBindVertexArray(0);
     }
 
-    void draw(GLuint shaderProgram) {
-        glUseProgram(shaderProgram);
+    // Pass the program the indicator was built with.
+    void draw(const ShaderProgram& shaderProgram) {
+        shaderProgram.use();
         glBindVertexArray(VAO);
 
-        GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
-        GLint viewLoc  = glGetUniformLocation(shaderProgram, "view");
-        GLint projLoc  = glGetUniformLocation(shaderProgram, "projection");
-
-        extern const float aspect_ratio; // Required to access the global constant in main.cpp
-        glm::mat4 view = glm::mat4(1.0f);
-        glm::mat4 projection = glm::ortho(-aspect_ratio, aspect_ratio, -1.0f, 1.0f, -1.0f, 1.0f);
-
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(x, y, 0.0f));
         model = glm::scale(model, glm::vec3(radius, radius, 1.0f));
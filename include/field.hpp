@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "raycast_kernel.hpp"
+
+// A wall, field element or game-piece edge the Robot View can see.
+struct Segment {
+    float x0, y0, x1, y1;
+    float r, g, b;
+};
+
+struct FieldHit {
+    float t;     // distance along the (unit) ray, inf on a miss
+    int segment; // index into Field::segments, -1 on a miss
+};
+
+// Arbitrary field geometry made of line segments, with a uniform grid over
+// it so a ray only tests the segments in the cells it crosses (walked with
+// Amanatides-Woo DDA) instead of every segment on the field.
+//
+// Text format for load(), one element per line, '#' starts a comment:
+//   color r g b                      colour for the elements that follow
+//   segment x0 y0 x1 y1
+//   polygon x0 y0 x1 y1 x2 y2 ...    closed, at least three points
+class Field {
+public:
+    std::vector<Segment> segments;
+
+    // The four walls the raycaster has always had, in the same colours.
+    static Field box(float limitX, float limitY);
+
+    void addSegment(float x0, float y0, float x1, float y1, float r, float g, float b);
+    void addPolygon(const std::vector<float>& xy, float r, float g, float b);
+
+    // Replaces the geometry with the file's and rebuilds the grid. On failure
+    // the field is left untouched and `error` says which line was bad.
+    bool load(const std::string& path, std::string& error);
+
+    // Must be called after adding geometry and before raycast().
+    void build();
+
+    // Nearest hit along direction (dx, dy) from (ox, oy); d must be unit length.
+    FieldHit raycast(float ox, float oy, float dx, float dy) const;
+
+    // Tests every segment; the reference for raycast().
+    FieldHit raycastBruteForce(float ox, float oy, float dx, float dy) const;
+
+private:
+    float minX = 0.0f, minY = 0.0f, cellSize = 1.0f;
+    int nx = 0, ny = 0;
+    // Compressed cell lists: cell c owns cellItems[cellStart[c] .. cellStart[c + 1]).
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> cellItems;
+
+    template <typename Visit>
+    void traverse(float ox, float oy, float dx, float dy, float tMax, Visit visit) const;
+};
+
+// castRays() against an arbitrary field. hitSegment gets the segment index
+// per column (-1 on a miss) and may be null.
+void castRays(const RayScan& scan, const Field& field, int count, float* depth, int32_t* hitSegment);
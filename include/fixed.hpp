@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Q16.16 fixed point, the format the co-processor runs its control loops in:
+// an int32 with 16 fraction bits, so about ±32768 with a resolution of
+// 1/65536. Products and quotients go through 64 bits, rounded the way the
+// target's instructions round them, which is not the same way: a product is
+// an arithmetic shift right, so it floors toward -inf (-1.5 LSB gives -2),
+// while a quotient is C++ integer division and truncates toward zero (-1.5
+// LSB gives -1). Replays and the regression sweeps depend on these exact
+// bits. Results saturate at the int32 limits instead of wrapping.
+// Conversions from float round to nearest.
+struct Fixed {
+    static constexpr int kFractionBits = 16;
+    static constexpr int64_t kOne = int64_t(1) << kFractionBits;
+
+    int32_t raw = 0;
+
+    constexpr Fixed() = default;
+    explicit Fixed(float f) : raw(fromReal(f)) {}
+    explicit Fixed(double f) : raw(fromReal(f)) {}
+
+    static constexpr Fixed fromRaw(int32_t r) {
+        Fixed f;
+        f.raw = r;
+        return f;
+    }
+
+    explicit operator float() const { return raw * (1.0f / kOne); }
+    explicit operator double() const { return raw * (1.0 / kOne); }
+
+    friend Fixed operator+(Fixed a, Fixed b) { return fromRaw(saturate((int64_t)a.raw + b.raw)); }
+    friend Fixed operator-(Fixed a, Fixed b) { return fromRaw(saturate((int64_t)a.raw - b.raw)); }
+    friend Fixed operator*(Fixed a, Fixed b) { return fromRaw(saturate(((int64_t)a.raw * b.raw) >> kFractionBits)); }
+    friend Fixed operator/(Fixed a, Fixed b) {
+        // Dividing by zero pins to whichever limit the sign points at.
+        if (b.raw == 0) return fromRaw(a.raw == 0 ? 0 : a.raw > 0 ? kMax : kMin);
+        return fromRaw(saturate(((int64_t)a.raw * kOne) / b.raw));
+    }
+    Fixed operator-() const { return fromRaw(saturate(-(int64_t)raw)); }
+
+    Fixed& operator+=(Fixed b) { return *this = *this + b; }
+    Fixed& operator-=(Fixed b) { return *this = *this - b; }
+    Fixed& operator*=(Fixed b) { return *this = *this * b; }
+    Fixed& operator/=(Fixed b) { return *this = *this / b; }
+
+    friend bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+    friend bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+    friend bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+    friend bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+    friend bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+    friend bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+
+private:
+    static constexpr int32_t kMax = std::numeric_limits<int32_t>::max();
+    static constexpr int32_t kMin = std::numeric_limits<int32_t>::min();
+
+    static constexpr int32_t saturate(int64_t v) {
+        return v > kMax ? kMax : v < kMin ? kMin : (int32_t)v;
+    }
+
+    // NaN becomes 0, anything out of range the nearest limit.
+    static int32_t fromReal(double f) {
+        double scaled = f * kOne;
+        if (!(scaled == scaled)) return 0;
+        if (scaled >= (double)kMax) return kMax;
+        if (scaled <= (double)kMin) return kMin;
+        return (int32_t)std::lround(scaled);
+    }
+};
+
+// Just enough for generic code (pidUnbounded) to ask for Fixed's range.
+namespace std {
+template <>
+class numeric_limits<Fixed> {
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool has_infinity = false;
+    static constexpr Fixed max() { return Fixed::fromRaw(numeric_limits<int32_t>::max()); }
+    static constexpr Fixed lowest() { return Fixed::fromRaw(numeric_limits<int32_t>::min()); }
+    static constexpr Fixed infinity() { return Fixed(); }
+};
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "robot.hpp"
+
+// Turns variable frame times into a whole number of fixed physics steps, so
+// simulated time no longer depends on how fast the windows swap. Whatever is
+// left over carries into the next frame and is used to interpolate the pose.
+class FixedStepClock {
+public:
+    double step;
+    // Cap so a long stall (window drag, breakpoint) doesn't queue up seconds
+    // of catch-up work; the excess time is dropped instead.
+    int maxStepsPerFrame = 1000;
+    double accumulator = 0.0;
+
+    explicit FixedStepClock(double stepSeconds) : step(stepSeconds) {}
+
+    // Adds `elapsed` real seconds and returns how many steps to run now.
+    int advance(double elapsed) {
+        accumulator += elapsed;
+        int steps = (int)(accumulator / step);
+        if (steps > maxStepsPerFrame) {
+            steps = maxStepsPerFrame;
+            accumulator = 0.0;
+        } else {
+            accumulator -= steps * step;
+        }
+        return steps;
+    }
+
+    // Fraction of a step between the last physics tick and now, in [0, 1).
+    float alpha() const { return (float)(accumulator / step); }
+};
+
+// Pose to draw between the last two physics ticks. SwerveDrive keeps the
+// previous tick in x_back/y_back/r_back, so that is all we need.
+inline SwerveDrive interpolatePose(const SwerveDrive& robot, float alpha) {
+    SwerveDrive shown(robot.x_back + (robot.x - robot.x_back) * alpha,
+                      robot.y_back + (robot.y - robot.y_back) * alpha);
+    shown.r = robot.r_back + (robot.r - robot.r_back) * alpha;
+    return shown;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "robot.hpp"
+
+// N independent robots stored struct-of-arrays, so one updatePose call walks
+// six contiguous streams and vectorizes. Robot i is x[i], y[i], r[i] etc.,
+// with the same meaning as the matching SwerveDrive fields.
+class Fleet {
+public:
+    std::vector<float> x, y, r;
+    std::vector<float> x_back, y_back, r_back;
+
+    Fleet() = default;
+    explicit Fleet(size_t count, float startX = 0.0f, float startY = 0.0f) {
+        for (size_t i = 0; i < count; i++) add(startX, startY);
+    }
+
+    size_t size() const { return x.size(); }
+
+    // Adds a robot at rest, like constructing a SwerveDrive there.
+    void add(float startX, float startY) {
+        x.push_back(startX);
+        y.push_back(startY);
+        r.push_back(0.0f);
+        x_back.push_back(startX);
+        y_back.push_back(startY);
+        r_back.push_back(0.0f);
+    }
+
+    // Same Verlet step as SwerveDrive::updatePose for every robot; each
+    // acceleration array holds size() entries and mustn't overlap the poses.
+    // The loop is left to the compiler to vectorize, and an AVX2 build of it
+    // is picked at runtime when the CPU has AVX2, so default (SSE2) builds
+    // get 8 lanes too. Bit-identical to updatePoseScalar either way.
+    void updatePose(const float* x_a, const float* y_a, const float* r_a, float dt);
+
+    // Plain one-lane loop, kept as the reference and for benchmarking.
+    void updatePoseScalar(const float* x_a, const float* y_a, const float* r_a, float dt);
+
+    // Which path updatePose takes on this machine: "avx2", "sse2" or "scalar".
+    static const char* simdPath();
+};
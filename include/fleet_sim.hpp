@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "fleet.hpp"
+#include "pid_bank.hpp"
+
+// Monte-Carlo spread: N robots chasing the same target, each starting
+// somewhere random with its gains jittered around a shared base. Physics is
+// one batched Fleet::updatePose per step, control one PIDBank::step per axis.
+class FleetSim {
+public:
+    Fleet fleet;
+    PIDBank pid_x, pid_y, pid_r;
+
+    // gainJitter = 0.2 scales each robot's gains by a random factor in [0.8, 1.2].
+    FleetSim(size_t count, const float moveGains[3], const float turnGains[3], float gainJitter, unsigned seed);
+
+    // Re-applies the jitter factors on top of new base gains.
+    void setGains(const float moveGains[3], const float turnGains[3]);
+
+    // Same control law as Simulation::step, for every robot.
+    void step(float targetX, float targetY, float dt);
+
+    size_t size() const { return fleet.size(); }
+
+private:
+    std::vector<float> moveScale, turnScale;
+    std::vector<float> ax, ay, ar; // errors in, accelerations out
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <deque>
+#include <vector>
+#include "profiler.hpp"
+#include "sim_thread.hpp"
+
+// GL_TIME_ELAPSED queries feeding one GPU track of a Profiler. Query objects
+// aren't shared between contexts, so make one timer per window, with that
+// window's context current for every call. Results are only picked up once
+// the GPU says they're ready, so the CPU never stalls on them; they land in
+// the profiler a frame or two late, placed at the time the work was issued.
+class GpuTimer {
+public:
+    GpuTimer(Profiler& p, Profiler::Track t) : profiler(p), track(t) {}
+
+    ~GpuTimer() {
+        for (const Pending& q : pending) spare.push_back(q.query);
+        if (!spare.empty()) glDeleteQueries((GLsizei)spare.size(), spare.data());
+    }
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    // Time elapsed queries can't nest, so begin/end pairs mustn't either.
+    void begin(const char* name) {
+        collect();
+
+        GLuint query;
+        if (spare.empty()) {
+            glGenQueries(1, &query);
+        } else {
+            query = spare.back();
+            spare.pop_back();
+        }
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        pending.push_back({query, name, SimClockNow()});
+    }
+
+    void end() {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+
+private:
+    struct Pending {
+        GLuint query;
+        const char* name;
+        double issued;
+    };
+
+    // Queries finish in order, so stop at the first that isn't ready.
+    void collect() {
+        while (!pending.empty()) {
+            const Pending& q = pending.front();
+            GLint ready = 0;
+            glGetQueryObjectiv(q.query, GL_QUERY_RESULT_AVAILABLE, &ready);
+            if (!ready) break;
+
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(q.query, GL_QUERY_RESULT, &ns);
+            // llvmpipe returns garbage for a context's very first query;
+            // nothing real on the GPU takes a whole second.
+            if (ns < 1000000000ull) profiler.record(track, q.name, q.issued, ns * 1e-9);
+            spare.push_back(q.query);
+            pending.pop_front();
+        }
+    }
+
+    Profiler& profiler;
+    Profiler::Track track;
+    std::deque<Pending> pending;
+    std::vector<GLuint> spare;
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <vector>
+#include <cmath>
+#include "shader_program.hpp"
+
+// One mesh instance: where it sits, how it's turned and sized, its colour.
+// Matches the iPose/iColor attributes in CreateInstancedProgram.
+struct Instance {
+    float x, y, angle, scale;
+    float r, g, b, a;
+};
+
+// Draws any number of robots and target markers with one instanced draw call
+// per mesh, instead of a draw call (plus uniform lookups) per object. Queue
+// things up with addRobot/addMarker each frame, then draw().
+class InstancedRenderer {
+private:
+    GLuint quadVAO, quadVBO, quadEBO, quadInstances;
+    GLuint circleVAO, circleVBO, circleEBO, circleInstances;
+    int circleIndexCount;
+    float chassisSize = 0.25f;
+
+    std::vector<Instance> quads, circles;
+
+    static void setupInstanceAttributes(GLuint instanceVBO) {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(4 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, 1);
+    }
+
+    static void makeMesh(GLuint& vao, GLuint& vbo, GLuint& ebo, GLuint& instanceVBO,
+                         const std::vector<float>& vertices, const std::vector<unsigned int>& indices) {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ebo);
+        glGenBuffers(1, &instanceVBO);
+
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        setupInstanceAttributes(instanceVBO);
+        glBindVertexArray(0);
+    }
+
+    // Orphans last frame's instance storage and uploads this frame's list.
+    static void upload(GLuint instanceVBO, const std::vector<Instance>& list) {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, list.size() * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, list.size() * sizeof(Instance), list.data());
+    }
+
+public:
+    InstancedRenderer() {
+        std::vector<float> quadVertices = {
+            -0.5f, -0.5f, 0.0f,
+             0.5f, -0.5f, 0.0f,
+             0.5f,  0.5f, 0.0f,
+            -0.5f,  0.5f, 0.0f 
+        };
+        std::vector<unsigned int> quadIndices = { 0, 1, 2, 2, 3, 0 };
+        makeMesh(quadVAO, quadVBO, quadEBO, quadInstances, quadVertices, quadIndices);
+
+        // Same unit fan as CircleIndicator.
+        std::vector<float> circleVertices = {0.0f, 0.0f, 0.0f};
+        std::vector<unsigned int> circleIndices;
+        int segments = 50;
+        for (int i = 0; i <= segments; i++) {
+            float angle = 2.0f * 3.14159265359f * (float)i / (float)segments;
+            circleVertices.push_back(cosf(angle));
+            circleVertices.push_back(sinf(angle));
+            circleVertices.push_back(0.0f);
+            if (i > 0) {
+                circleIndices.push_back(0);
+                circleIndices.push_back(i);
+                circleIndices.push_back(i + 1);
+            }
+        }
+        circleIndexCount = circleIndices.size();
+        makeMesh(circleVAO, circleVBO, circleEBO, circleInstances, circleVertices, circleIndices);
+    }
+
+    ~InstancedRenderer() {
+        GLuint buffers[] = {quadVBO, quadEBO, quadInstances, circleVBO, circleEBO, circleInstances};
+        glDeleteBuffers(6, buffers);
+        GLuint vaos[] = {quadVAO, circleVAO};
+        glDeleteVertexArrays(2, vaos);
+    }
+
+    InstancedRenderer(const InstancedRenderer&) = delete;
+    InstancedRenderer& operator=(const InstancedRenderer&) = delete;
+
+    void clear() {
+        quads.clear();
+        circles.clear();
+    }
+
+    // Chassis plus the white front marker, laid out like SwerveDriveRenderer.
+    void addRobot(float x, float y, float r, glm::vec4 color) {
+        quads.push_back({x, y, r, chassisSize, color.r, color.g, color.b, color.a});
+
+        float offset = 0.4f * chassisSize;
+        quads.push_back({x - sinf(r) * offset, y + cosf(r) * offset, r, 0.2f * chassisSize,
+                         1.0f, 1.0f, 1.0f, color.a});
+    }
+
+    void addMarker(float x, float y, float radius, glm::vec4 color) {
+        circles.push_back({x, y, 0.0f, radius, color.r, color.g, color.b, color.a});
+    }
+
+    // Two draw calls total, however many robots and markers were queued.
+    // No uniforms to set: the camera is in the UBO, the rest is per instance.
+    void draw(const ShaderProgram& shader) {
+        shader.use();
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        if (!quads.empty()) {
+            upload(quadInstances, quads);
+            glBindVertexArray(quadVAO);
+            glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, (GLsizei)quads.size());
+        }
+        if (!circles.empty()) {
+            upload(circleInstances, circles);
+            glBindVertexArray(circleVAO);
+            glDrawElementsInstanced(GL_TRIANGLES, circleIndexCount, GL_UNSIGNED_INT, 0, (GLsizei)circles.size());
+        }
+
+        glBindVertexArray(0);
+        glDisable(GL_BLEND);
+    }
+};
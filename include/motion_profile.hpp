@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include "robot.hpp"
+#include "sim.hpp"
+
+// Speed limits for a motion profile. maxJerk = 0 gives a trapezoidal
+// velocity profile; anything else rounds its corners into an S-curve.
+struct ProfileLimits {
+    float maxVel = 1.0f;
+    float maxAccel = 4.0f;
+    float maxJerk = 0.0f;
+};
+
+// Distance along the path, and its first two derivatives.
+struct ProfileSample {
+    float pos, vel, acc;
+};
+
+// Rest-to-rest move over a distance, built once into a table with one sample
+// per sim tick, then read back in O(1) per tick. The S-curve is the
+// trapezoid run through a moving average maxAccel / maxJerk seconds wide
+// (twice that for moves too short to cruise), which limits jerk and still
+// ends exactly at the distance. It's a little slower than a true
+// seven-segment profile, but needs no case analysis.
+class MotionProfile {
+public:
+    // Rebuilds the table; reuses its storage, so repeated builds of similar
+    // moves don't allocate.
+    void build(float distance, const ProfileLimits& limits, float dt);
+
+    float duration() const { return samples.empty() ? 0.0f : (samples.size() - 1) * step; }
+
+    // Linear between the two nearest samples; holds the end once past it.
+    ProfileSample sample(float t) const {
+        if (samples.empty()) return {0.0f, 0.0f, 0.0f};
+        float k = t / step;
+        if (!(k > 0.0f)) return samples.front();
+        size_t i = (size_t)k;
+        if (i + 1 >= samples.size()) return samples.back();
+        float f = k - (float)i;
+        const ProfileSample& a = samples[i];
+        const ProfileSample& b = samples[i + 1];
+        return {a.pos + (b.pos - a.pos) * f, a.vel + (b.vel - a.vel) * f, a.acc + (b.acc - a.acc) * f};
+    }
+
+    const std::vector<ProfileSample>& table() const { return samples; }
+
+private:
+    std::vector<ProfileSample> samples, raw;
+    float step = 0.01f;
+};
+
+// Turns target jumps into references for Simulation::step. Whenever the
+// target moves it profiles a straight line from where the robot is to the
+// new target, then hands out that line's setpoint one tick at a time. The
+// feedforward is the acceleration that keeps SwerveDrive's Verlet step (with
+// its friction) on the profile: a + (1 - friction) * v / dt.
+class ProfileFollower {
+public:
+    ProfileLimits limits;
+
+    Reference next(float targetX, float targetY, const SwerveDrive& robot, float dt);
+
+    const MotionProfile& profile() const { return motion; }
+
+private:
+    MotionProfile motion;
+    float goalX = 0.0f, goalY = 0.0f;
+    float startX = 0.0f, startY = 0.0f;
+    float dirX = 0.0f, dirY = 0.0f;
+    float builtDt = 0.0f;
+    long long tick = 0;
+    bool started = false;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Surfaceless EGL context (Mesa's llvmpipe is fine), so pid_sim can render
+// on a box with no display. Makes itself current and loads GL through glad.
+class OffscreenContext {
+public:
+    OffscreenContext();
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    bool ok() const { return context != nullptr; }
+    const std::string& error() const { return message; }
+
+private:
+    // EGLDisplay / EGLContext, kept opaque so EGL headers stay out of here.
+    void* display = nullptr;
+    void* context = nullptr;
+    std::string message;
+};
+
+// Framebuffer with one RGB color buffer, standing in for a window.
+class FrameTarget {
+public:
+    const int width, height;
+
+    FrameTarget(int w, int h);
+    ~FrameTarget();
+
+    FrameTarget(const FrameTarget&) = delete;
+    FrameTarget& operator=(const FrameTarget&) = delete;
+
+    // Draw into this target from now on (also sets the viewport).
+    void bind();
+    // Tightly packed RGB, bottom row first like GL hands it back.
+    void read(std::vector<unsigned char>& rgb);
+
+private:
+    GLuint fbo, color;
+};
+
+// Saves frames on a background thread, so the render loop only pays for
+// glReadPixels. Either one binary PPM per frame, or every frame appended to
+// a raw RGB24 stream (ffmpeg -f rawvideo -pix_fmt rgb24 -s WxH). When
+// maxQueued frames are waiting, write() blocks instead of piling up memory.
+class FrameWriter {
+public:
+    enum Format { PPM, Raw };
+
+    explicit FrameWriter(Format format, size_t maxQueued = 8);
+    // Finishes everything still queued.
+    ~FrameWriter();
+
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    // A pixel buffer to read the next frame into; recycled from earlier writes.
+    std::vector<unsigned char> buffer();
+
+    // Queues `rgb` (bottom row first, as from FrameTarget::read) to go out to
+    // `path`: its own file for PPM, appended for Raw.
+    void write(const std::string& path, int width, int height, std::vector<unsigned char>&& rgb);
+
+    // Blocks until every queued frame is on disk.
+    void flush();
+    // Frames that could not be written so far.
+    int failures() const;
+
+private:
+    struct Frame {
+        std::string path;
+        int width, height;
+        std::vector<unsigned char> rgb;
+    };
+
+    void run();
+    bool save(const Frame& frame);
+
+    Format format;
+    size_t maxQueued;
+    std::deque<Frame> queue;
+    std::vector<std::vector<unsigned char>> spare;
+    std::map<std::string, FILE*> streams;
+    int failed = 0;
+    bool done = false;
+
+    mutable std::mutex mutex;
+    std::condition_variable ready, drained;
+    std::thread thread;
+};
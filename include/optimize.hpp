@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include "sweep.hpp"
+
+// CMA-ES search over all six gains (move P/I/D, turn P/I/D) for the lowest
+// runCost() on a scenario. Each generation's candidates are scored in
+// parallel on the pool; runs that blow up are cut short by evaluateGains
+// (see Scenario::divergeLimit) and simply rank last.
+struct OptimizerConfig {
+    Gains lower = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+    Gains upper = {{20.0f, 5.0f, 20.0f}, {20.0f, 5.0f, 20.0f}};
+    Gains start = {{1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}};
+    float initialSigma = 0.3f; // step size, as a fraction of each gain's range
+    int populationSize = 0;    // 0 picks the usual 4 + 3 ln(6) = 9
+    int maxEvaluations = 3000;
+    unsigned seed = 1;
+};
+
+struct OptimizerResult {
+    RunResult best;
+    float bestCost = 0.0f;
+    int evaluations = 0;
+    int generations = 0;
+    int diverged = 0; // candidates cut short along the way
+};
+
+// Called after every generation with the best cost found so far.
+using OptimizerProgress = std::function<void(int generation, int evaluations, float bestCost)>;
+
+OptimizerResult optimizeGains(const Scenario& scenario, const OptimizerConfig& config, ThreadPool& pool,
+                              const OptimizerProgress& progress = nullptr);
@@ -1,22 +1,65 @@
 #pragma once
 
-class PID {
+#include <algorithm>
+#include <limits>
+
+// Largest magnitude T can hold: infinity for float/double, the range limit
+// for Fixed. Output limits at ±this never bind.
+template <typename T>
+T pidUnbounded() {
+    using L = std::numeric_limits<T>;
+    return L::has_infinity ? L::infinity() : L::max();
+}
+
+// PID over any numeric type with + - * /: float for the sim, double for
+// reference runs, Fixed (fixed.hpp) for the co-processor's exact arithmetic.
+//
+// The output is clamped to [out_min, out_max], and two anti-windup schemes
+// can keep the integrator from running away while it is: back-calculation
+// feeds back_calc * (clamped - unclamped output) into e_accum, and
+// conditional integration stops integrating errors that would push further
+// into the limit. Everything is min/max/select so batches of these still
+// vectorize. The defaults switch all of it off, bit for bit.
+template <typename T>
+class BasicPID {
 public:
 
-    float P, I, D;
+    T P, I, D;
 
-    float e_accum = 0.0f; 
-    float e_back = 0.0f; 
+    T e_accum{};
+    T e_back{};
 
-    PID(float p_gain, float i_gain, float d_gain) : P(p_gain), I(i_gain), D(d_gain) {} 
+    T out_min = -pidUnbounded<T>();
+    T out_max = pidUnbounded<T>();
+    T back_calc{};
+    bool conditional_integration = false;
 
-    float calculate_error(float e, float dt) {
+    // Whether the last output was clamped.
+    bool saturated = false;
 
-        //TODO Make the bounds 
-        float return_e = P * e + I * e_accum + D * (e - e_back) / dt; 
-        e_accum += e * dt; 
-        e_back = e; 
+    BasicPID(T p_gain, T i_gain, T d_gain) : P(p_gain), I(i_gain), D(d_gain) {}
 
-        return return_e; 
+    void setLimits(T lo, T hi) {
+        out_min = lo;
+        out_max = hi;
     }
-};
\ No newline at end of file
+
+    T calculate_error(T e, T dt) {
+
+        T raw = P * e + I * e_accum + D * (e - e_back) / dt;
+        T out = std::min(std::max(raw, out_min), out_max); // keeps NaN
+
+        // Nonzero only while clamped (or once raw is inf/NaN, but by then
+        // the run has diverged anyway).
+        T excess = out - raw;
+        saturated = excess != T{};
+        bool windingUp = conditional_integration & (e * excess < T{});
+
+        e_accum += ((windingUp ? T{} : e) + back_calc * excess) * dt;
+        e_back = e;
+
+        return out;
+    }
+};
+
+using PID = BasicPID<float>;
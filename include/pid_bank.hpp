@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// N independent PIDs stored struct-of-arrays, the controller counterpart of
+// Fleet: one step() walks contiguous streams and vectorizes. Controller i is
+// P[i], I[i], ... with the same meaning as the matching PID fields, and the
+// same control law, clamp and anti-windup as PID::calculate_error, except
+// that 1/dt is worked out once per step, so D terms can round differently
+// from PID's divide in the last bit.
+class PIDBank {
+public:
+    std::vector<float> P, I, D;
+    std::vector<float> e_accum, e_back;
+    std::vector<float> out_min, out_max;
+    // Shared by the whole bank.
+    float back_calc = 0.0f;
+    bool conditional_integration = false;
+
+    PIDBank() = default;
+    explicit PIDBank(size_t count, float p_gain = 0.0f, float i_gain = 0.0f, float d_gain = 0.0f) {
+        for (size_t k = 0; k < count; k++) add(p_gain, i_gain, d_gain);
+    }
+
+    size_t size() const { return P.size(); }
+
+    // Adds an unbounded controller at rest, like constructing a PID.
+    void add(float p_gain, float i_gain, float d_gain);
+
+    // errors and out hold size() entries each (out may be errors). Uses AVX
+    // or SSE when the core is built with them and gives bit-identical
+    // results to stepScalar.
+    void step(const float* errors, float dt, float* out);
+
+    // Plain one-lane loop, kept as the reference and for benchmarking.
+    void stepScalar(const float* errors, float dt, float* out);
+
+    // Which path step was compiled with: "avx", "sse" or "scalar".
+    static const char* simdPath();
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Frame profiler for the render loop. Stages are recorded as (track, name,
+// start, duration) events: CPU scopes on the render thread, GPU times from
+// timer queries (see gpu_timer.hpp), and whatever the sim thread reports.
+// Keeps a rolling average per stage for the overlay, plus the last
+// maxEvents events for a Chrome trace (chrome://tracing, Perfetto).
+//
+// Render thread only. Names must be string literals (or otherwise outlive
+// the profiler); they're compared by content but stored as pointers.
+class Profiler {
+public:
+    enum Track { Cpu, GpuMap, GpuView, Sim, kTracks };
+
+    struct Stage {
+        const char* name;
+        Track track;
+        float averageMs = 0.0f; // exponential moving average over frames
+        float lastMs = 0.0f;    // total in the last finished frame
+        float frameMs = 0.0f;   // running total for the current frame
+    };
+
+    explicit Profiler(size_t maxEvents = 1 << 16);
+
+    // Closes the previous frame's totals into the averages.
+    void beginFrame();
+
+    // start is a SimClockNow() time, seconds.
+    void record(Track track, const char* name, double start, double seconds);
+
+    const std::vector<Stage>& stages() const { return stageList; }
+    float frameAverageMs() const { return frameAverage; }
+
+    bool writeChromeTrace(const std::string& path) const;
+
+    static const char* trackName(Track track);
+
+private:
+    struct Event {
+        const char* name;
+        Track track;
+        double start, seconds;
+    };
+
+    std::vector<Event> events; // ring once full
+    size_t nextEvent = 0;
+    bool wrapped = false;
+
+    std::vector<Stage> stageList;
+    double frameStart = -1.0;
+    float frameAverage = 0.0f;
+    double origin;
+};
+
+// Times its own lifetime on the profiler's CPU track.
+class ProfileScope {
+public:
+    ProfileScope(Profiler& p, const char* stageName);
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler& profiler;
+    const char* name;
+    double start;
+};
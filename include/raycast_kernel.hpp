@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+// GL-free version of the Robot View's per-ray work, so depth columns can be
+// produced headless. Rays fan evenly across `fovRad` around the robot's
+// front (heading + 90 degrees), exactly like Raycaster::updateAndDraw, and
+// hit the box walls at x = +-limitX, y = +-limitY.
+struct RayScan {
+    float x, y, heading;
+    float fovRad;
+    float limitX = 1.0f, limitY = 1.0f;
+    // false: Euclidean range along each ray, what a range sensor reports.
+    // true: distance along the view direction (fisheye-corrected), what the
+    // Robot View draws. Only meaningful for fovRad < pi; past +-90 degrees
+    // the projection goes negative.
+    bool perpendicular = false;
+};
+
+// Which wall a ray stopped on.
+enum RayWall : uint8_t { WallX = 0, WallY = 1 };
+
+// Direction the middle ray points in (heading + 90 degrees), wrapped into
+// [-pi, pi] in double so ray angles stay small however far the heading has
+// wound up. Both cast paths and the field caster build their rays from it.
+float scanCenter(const RayScan& scan);
+
+// Writes `count` distances (see RayScan::perpendicular), plus the wall hit for each ray
+// if `wall` isn't null. Runs 8 rays at a time with AVX2 whenever the CPU
+// has it, picked at runtime so default builds get it too; otherwise the
+// same as castRaysScalar.
+void castRays(const RayScan& scan, int count, float* depth, uint8_t* wall);
+
+// One ray at a time with libm cos/sin; the reference for the SIMD path.
+void castRaysScalar(const RayScan& scan, int count, float* depth, uint8_t* wall);
+
+// "avx2" or "scalar", whichever castRays takes on this machine.
+const char* castRaysPath();
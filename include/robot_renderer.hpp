@@ -0,0 +1,69 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <vector>
+#include "robot.hpp"
+#include "shader_program.hpp"
+
+// GL side of the drivetrain. Owns the chassis mesh and draws whatever pose
+// the SwerveDrive currently holds; it never writes to the physics state.
+class SwerveDriveRenderer {
+private:
+    GLuint VAO, VBO, EBO;
+    float chassisSize = 0.25f;
+    // In the map program, resolved once here instead of every draw.
+    GLint modelLoc, colorLoc;
+
+public:
+    explicit SwerveDriveRenderer(const ShaderProgram& shaderProgram)
+        : modelLoc(shaderProgram.uniform("model")), colorLoc(shaderProgram.uniform("uColor")) {
+        std::vector<float> vertices = {
+            -0.5f, -0.5f, 0.0f,
+             0.5f, -0.5f, 0.0f,
+             0.5f,  0.5f, 0.0f,
+            -0.5f,  0.5f, 0.0f 
+        };
+        std::vector<unsigned int> indices = { 0, 1, 2, 2, 3, 0 };
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+    }
+
+    // View/projection come from the Camera block. Pass the program this
+    // renderer was built with.
+    void draw(const ShaderProgram& shaderProgram, const SwerveDrive& robot) {
+        shaderProgram.use();
+        glBindVertexArray(VAO);
+
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(robot.x, robot.y, 0.0f));
+        model = glm::rotate(model, robot.r, glm::vec3(0.0f, 0.0f, 1.0f));
+        model = glm::scale(model, glm::vec3(chassisSize, chassisSize, 1.0f));
+
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+        glUniform4f(colorLoc, 0.0f, 0.0f, 0.8f, 1.0f);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+        glm::mat4 frontModel = glm::scale(model, glm::vec3(0.2f, 0.2f, 1.0f));
+        frontModel = glm::translate(frontModel, glm::vec3(0.0f, 2.0f, 0.01f));
+        
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(frontModel));
+        glUniform4f(colorLoc, 1.0f, 1.0f, 1.0f, 1.0f);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+        glBindVertexArray(0);
+    }
+};
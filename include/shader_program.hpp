@@ -0,0 +1,162 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+// Linked vertex + fragment program. Compile and link logs go to stderr
+// (check ok()), and every active uniform's location is read once at link
+// time so draw code never asks the driver by name again.
+class ShaderProgram {
+public:
+    // Binding point shared by every program that declares the Camera block.
+    static constexpr GLuint kCameraBinding = 0;
+
+    ShaderProgram(const char* name, const char* vertexSource, const char* fragmentSource) {
+        GLuint vertexShader = compile(name, GL_VERTEX_SHADER, vertexSource);
+        GLuint fragmentShader = compile(name, GL_FRAGMENT_SHADER, fragmentSource);
+
+        id = glCreateProgram();
+        glAttachShader(id, vertexShader);
+        glAttachShader(id, fragmentShader);
+        glLinkProgram(id);
+
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+
+        GLint status;
+        glGetProgramiv(id, GL_LINK_STATUS, &status);
+        if (!status) {
+            std::cerr << name << ": link failed\n" << infoLog(id, false) << std::endl;
+            linked = false;
+            return;
+        }
+
+        cacheUniforms();
+
+        GLuint cameraBlock = glGetUniformBlockIndex(id, "Camera");
+        if (cameraBlock != GL_INVALID_INDEX) glUniformBlockBinding(id, cameraBlock, kCameraBinding);
+    }
+
+    ~ShaderProgram() {
+        if (id) glDeleteProgram(id);
+    }
+
+    ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+    ShaderProgram(ShaderProgram&& other) noexcept
+        : id(other.id), linked(other.linked), uniforms(std::move(other.uniforms)) {
+        other.id = 0;
+    }
+
+    bool ok() const { return linked; }
+    GLuint handle() const { return id; }
+    void use() const { glUseProgram(id); }
+
+    // -1 (which glUniform* ignores) if the shader has no such uniform or the
+    // compiler optimized it out. Still a hash lookup by name, so renderers
+    // call this once when they're set up and keep the GLint.
+    GLint uniform(const std::string& name) const {
+        auto it = uniforms.find(name);
+        return (it == uniforms.end()) ? -1 : it->second;
+    }
+
+private:
+    GLuint id = 0;
+    bool linked = true;
+    std::unordered_map<std::string, GLint> uniforms;
+
+    GLuint compile(const char* name, GLenum type, const char* source) {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+
+        GLint status;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+        if (!status) {
+            const char* stage = (type == GL_VERTEX_SHADER) ? "vertex" : "fragment";
+            std::cerr << name << ": " << stage << " shader failed to compile\n"
+                      << infoLog(shader, true) << std::endl;
+            linked = false;
+        }
+        return shader;
+    }
+
+    static std::string infoLog(GLuint object, bool isShader) {
+        GLint length = 0;
+        if (isShader) glGetShaderiv(object, GL_INFO_LOG_LENGTH, &length);
+        else glGetProgramiv(object, GL_INFO_LOG_LENGTH, &length);
+        if (length <= 0) return std::string();
+
+        std::string log(length, '\0');
+        if (isShader) glGetShaderInfoLog(object, length, NULL, &log[0]);
+        else glGetProgramInfoLog(object, length, NULL, &log[0]);
+        return log;
+    }
+
+    void cacheUniforms() {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::string buffer(maxLength > 0 ? maxLength : 1, '\0');
+        for (GLint i = 0; i < count; i++) {
+            GLsizei length = 0;
+            GLint size;
+            GLenum type;
+            glGetActiveUniform(id, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, &buffer[0]);
+
+            std::string name(buffer.data(), length);
+            GLint location = glGetUniformLocation(id, name.c_str());
+            // Block members have no location; they come from the UBO.
+            if (location < 0) continue;
+
+            // Arrays are reported as "name[0]"; let callers use the bare name.
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+                name.resize(name.size() - 3);
+            }
+            uniforms[name] = location;
+        }
+    }
+};
+
+// std140 `Camera { mat4 view; mat4 projection; }` block shared by every map
+// program. Write it once per frame instead of setting the same two matrices
+// on each program before each draw.
+class CameraBuffer {
+public:
+    CameraBuffer() {
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    ~CameraBuffer() {
+        glDeleteBuffers(1, &ubo);
+    }
+
+    CameraBuffer(const CameraBuffer&) = delete;
+    CameraBuffer& operator=(const CameraBuffer&) = delete;
+
+    // Binding points are per context, so call this once in each context
+    // that draws with the camera (the buffer itself is shared).
+    void bind() const {
+        glBindBufferBase(GL_UNIFORM_BUFFER, ShaderProgram::kCameraBinding, ubo);
+    }
+
+    void update(const glm::mat4& view, const glm::mat4& projection) {
+        // Two column-major mat4s are already std140 layout.
+        glm::mat4 matrices[2] = {view, projection};
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(matrices), glm::value_ptr(matrices[0]));
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+private:
+    GLuint ubo;
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "fixed.hpp"
+#include "pid.hpp"
+#include "robot.hpp"
+#include "telemetry.hpp"
+
+// Per-tick errors to the target, handy for scoring a run. Without a
+// Reference these are also what the controllers see.
+struct SimError {
+    float dx, dy, dr;
+};
+
+// Where the robot should be this tick on its way to the target, e.g. from a
+// ProfileFollower. The translation PIDs chase (x, y) instead of the target,
+// and ff is added to their output. In cascade mode v is added to the
+// velocity setpoint as well. Heading still faces the target.
+struct Reference {
+    float x, y;
+    float vx, vy;
+    float ffX, ffY;
+};
+
+// Fires on the first call and then once every `every` calls; the cascade's
+// loops each run off one of these at an integer fraction of the physics rate.
+struct RateDivider {
+    int every = 1;
+    int countdown = 0;
+
+    bool due() {
+        if (countdown > 0) {
+            countdown--;
+            return false;
+        }
+        countdown = every - 1;
+        return true;
+    }
+
+    // Keeps the phase unless the new period is shorter than what's left.
+    void setEvery(int n) {
+        every = n < 1 ? 1 : n;
+        if (countdown >= every) countdown = every - 1;
+    }
+};
+
+// Cascaded control, the way real swerve code splits it: the position PIDs
+// (pid_x/y/r) run every outerEvery physics ticks and output a velocity
+// setpoint; velocity PIDs (vel_x/y/r) run every innerEvery ticks, compare it
+// with the Verlet velocity and output the acceleration. Each holds its output
+// until it runs again. E.g. dt = 1 ms, outerEvery = 20, innerEvery = 1 is a
+// 50 Hz position loop over 1 kHz velocity loops.
+struct CascadeConfig {
+    bool enabled = false;
+    int outerEvery = 20;
+    int innerEvery = 1;
+    float moveVelGains[3] = {20.0f, 0.0f, 0.0f};
+    float turnVelGains[3] = {20.0f, 0.0f, 0.0f};
+};
+
+// One robot plus its three controllers, stepped without any GL context.
+// This is the same loop main() used to run inline every frame. T is the
+// controllers' arithmetic; the physics stays float either way, and errors
+// and outputs are converted at the boundary. Instantiated in sim.cpp for
+// float, double and Fixed.
+template <typename T>
+class BasicSimulation {
+public:
+    SwerveDrive robot;
+    BasicPID<T> pid_x, pid_y, pid_r;
+    // Inner loops, only used when cascaded.
+    BasicPID<T> vel_x, vel_y, vel_r;
+
+    BasicSimulation(const float moveGains[3], const float turnGains[3], float startX = 0.0f, float startY = 0.0f);
+
+    void setGains(const float moveGains[3], const float turnGains[3]);
+
+    // Switching the cascade on or off starts the inner loops from rest;
+    // changing rates or gains while it runs keeps their state.
+    void setCascade(const CascadeConfig& config);
+    bool isCascaded() const { return cascaded; }
+
+    // Holds each tick's accelerations back this many ticks before they reach
+    // the robot, like the bus and motor controllers on a real drivetrain.
+    // 0, the default, applies them the tick they're computed.
+    void setActuationDelay(int ticks);
+
+    // Chase (targetX, targetY): translate onto it and turn the front to face it.
+    // Pass `terms` to also get each controller's P/I/D breakdown for the tick.
+    // In cascade mode `terms` describes the position loops as of their last
+    // run, so their output is the velocity setpoint.
+    SimError step(float targetX, float targetY, float dt, SimTerms* terms = nullptr, const Reference* ref = nullptr);
+
+private:
+    SimError stepCascaded(float dx, float dy, float dr, float dt, SimTerms* terms, const Reference* ref);
+    void actuate(float ax, float ay, float ar, float dt);
+
+    bool cascaded = false;
+    RateDivider outer, inner;
+    T vref_x{}, vref_y{}, vref_r{};
+    T accel_x{}, accel_y{}, accel_r{};
+    SimTerms outerTerms{};
+    // Accelerations still on their way to the robot, oldest at pendingHead.
+    std::vector<std::array<float, 3>> pending;
+    size_t pendingHead = 0;
+};
+
+extern template class BasicSimulation<float>;
+extern template class BasicSimulation<double>;
+extern template class BasicSimulation<Fixed>;
+
+using Simulation = BasicSimulation<float>;
+
+// Which BasicSimulation a headless run uses.
+enum class PIDBackend { Float, Double, Fixed };
+
+const char* backendName(PIDBackend backend);
+// "float", "double" or "fixed"; false (and `out` untouched) otherwise.
+bool parseBackend(const char* name, PIDBackend& out);
+
+// What pid.calculate_error(e, dt) is about to return, split into its terms.
+// Call it before calculate_error; it reads the same e_accum/e_back.
+template <typename T>
+inline PIDTerms pidTerms(const BasicPID<T>& pid, T e, T dt) {
+    T p = pid.P * e;
+    T i = pid.I * pid.e_accum;
+    T d = pid.D * (e - pid.e_back) / dt;
+    PIDTerms t;
+    t.error = (float)e;
+    t.p = (float)p;
+    t.i = (float)i;
+    t.d = (float)d;
+    t.output = (float)std::min(std::max(p + i + d, pid.out_min), pid.out_max);
+    return t;
+}
+
+// Wraps an angle difference into [-pi, pi] in constant time, however far the
+// heading has wound up. Non-finite input comes back NaN.
+float wrapAngle(float a);
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <string>
+#include "motion_profile.hpp"
+#include "sim.hpp"
+#include "telemetry.hpp"
+#include "trace.hpp"
+#include "triple_buffer.hpp"
+
+// What the render thread hands to the sim each frame.
+struct SimInput {
+    float targetX = 0.0f, targetY = 0.0f;
+    float moveGains[3] = {1.0f, 0.0f, 0.0f};
+    float turnGains[3] = {1.0f, 0.0f, 0.0f};
+    float dt = 0.01f;
+    // Sim seconds per real second; 0 runs as fast as the CPU allows.
+    float speed = 1.0f;
+    CascadeConfig cascade;
+    // Reach each new target along a motion profile instead of in one jump.
+    bool profiled = false;
+    ProfileLimits profile;
+};
+
+// What the sim publishes after each batch of ticks. Copies, so the renderer
+// can read them while the sim keeps stepping.
+struct SimSnapshot {
+    SwerveDrive robot{0.0f, 0.0f};
+    PID pid_x{0.0f, 0.0f, 0.0f}, pid_y{0.0f, 0.0f, 0.0f}, pid_r{0.0f, 0.0f, 0.0f};
+    SimError error{0.0f, 0.0f, 0.0f};
+    uint64_t tick = 0;
+    float dt = 0.01f;
+    float speed = 1.0f;
+    // Simulated seconds so far (sum of every tick's dt).
+    double simTime = 0.0;
+    // SimClockNow() time of the last tick, for interpolating the drawn pose.
+    double tickTime = 0.0;
+    // Wall time spent stepping this batch (PID + updatePose for every tick),
+    // for the profiler.
+    double batchStart = 0.0;
+    double batchSeconds = 0.0;
+    int batchTicks = 0;
+};
+
+// Monotonic seconds shared by the sim thread and the renderer.
+double SimClockNow();
+
+// Runs Simulation on its own thread at a fixed step of SimInput::dt, paced to
+// SimInput::speed times real time (or flat out), so the control loop never
+// waits on vsync or GL. Talks to the render thread only through two
+// lock-free triple buffers.
+class SimThread {
+public:
+    // Keeps the last telemetryCapacity ticks of telemetry (rounded up to a
+    // power of two).
+    explicit SimThread(const SimInput& initial, size_t telemetryCapacity = 1 << 18);
+    ~SimThread();
+
+    SimThread(const SimThread&) = delete;
+    SimThread& operator=(const SimThread&) = delete;
+
+    // Writes every tick to a binary trace for replayTrace(). Call before start().
+    bool record(const std::string& path);
+
+    void start();
+    void stop();
+
+    // Render thread only.
+    void setInput(const SimInput& in) { input.write(in); }
+    const SimSnapshot& latest() {
+        output.update();
+        return output.readBuffer();
+    }
+    // Safe to read from any thread while the sim writes it.
+    const TelemetryRing& telemetry() const { return telemetryRing; }
+
+private:
+    void run();
+
+    Simulation sim;
+    ProfileFollower follower;
+    TraceWriter recorder;
+    TelemetryRing telemetryRing;
+    TripleBuffer<SimInput> input;
+    TripleBuffer<SimSnapshot> output;
+    std::atomic<bool> running{false};
+    std::thread thread;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+// One-lane reference loops (Fleet::updatePoseScalar, PIDBank::stepScalar,
+// the benchmarks' per-object loops) are marked so -O3 can't vectorize them
+// too; otherwise "scalar vs batched" would time SIMD against SIMD. GCC takes
+// it per function (PIDSIM_SCALAR_REFERENCE), Clang per loop
+// (PIDSIM_NO_VECTORIZE_LOOP right before the `for`), so use both.
+#if defined(__clang__)
+#define PIDSIM_SCALAR_REFERENCE __attribute__((noinline))
+#define PIDSIM_NO_VECTORIZE_LOOP _Pragma("clang loop vectorize(disable) interleave(disable)")
+#elif defined(__GNUC__)
+#define PIDSIM_SCALAR_REFERENCE __attribute__((noinline, optimize("no-tree-vectorize", "no-tree-slp-vectorize")))
+#define PIDSIM_NO_VECTORIZE_LOOP
+#else
+#define PIDSIM_SCALAR_REFERENCE
+#define PIDSIM_NO_VECTORIZE_LOOP
+#endif
+
+// Runtime dispatch for the batched kernels. The default build only assumes
+// SSE2 (PIDSIM_NATIVE is off), so a kernel can compile a second copy of its
+// loop under PIDSIM_TARGET_AVX2 and call it when cpuHasAvx2() says so. Only
+// AVX2 is enabled, not FMA, so no multiply-add gets contracted and the copy
+// rounds exactly like the default one. PIDSIM_X86_DISPATCH is 0 where this
+// isn't available (other compilers or CPUs); cpuHasAvx2() is then false.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PIDSIM_X86_DISPATCH 1
+#define PIDSIM_TARGET_AVX2 __attribute__((target("avx2")))
+#define PIDSIM_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define PIDSIM_X86_DISPATCH 0
+#define PIDSIM_TARGET_AVX2
+#define PIDSIM_ALWAYS_INLINE inline
+#endif
+
+bool cpuHasAvx2();
+
+// What pidsim_core itself was compiled for, so benchmark runs can say which
+// build they came from: PIDSIM_NATIVE, and the instruction sets enabled.
+struct CoreBuild {
+    bool native;
+    bool sse2, avx, avx2, fma;
+};
+
+CoreBuild coreBuild();
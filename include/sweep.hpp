@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <vector>
+#include "motion_profile.hpp"
+#include "sim.hpp"
+#include "thread_pool.hpp"
+
+// Translation (pid_x/pid_y) and rotation (pid_r) gains, same layout as
+// TuningState::moveGains/turnGains.
+struct Gains {
+    float move[3];
+    float turn[3];
+};
+
+// Scripted target for a headless run: start at rest, then chase a fixed point.
+struct Scenario {
+    float startX = 0.0f, startY = 0.0f;
+    float targetX = 0.5f, targetY = 0.5f;
+    float duration = 10.0f;
+    float dt = 0.01f;
+    // Actuation latency in seconds, rounded to whole ticks of dt; see
+    // BasicSimulation::setActuationDelay.
+    float latency = 0.0f;
+    // Settled once the error stays inside this fraction of the initial error.
+    float settleBand = 0.02f;
+    // A run is cut short as diverged once the pose or any integrator leaves
+    // [-divergeLimit, divergeLimit] (or goes inf/NaN). The field is only 2 wide.
+    float divergeLimit = 1e4f;
+    // Controller arithmetic; Fixed reproduces the co-processor bit for bit.
+    PIDBackend backend = PIDBackend::Float;
+    // Output clamps (acceleration) and anti-windup, see BasicPID. The
+    // defaults leave the controllers unbounded.
+    float moveLimit = INFINITY, turnLimit = INFINITY;
+    float backCalculation = 0.0f;
+    bool conditionalIntegration = false;
+    // Stop a run the first tick any controller hits its limit.
+    bool skipSaturated = false;
+    // Position loops over velocity loops; Gains are then the position gains
+    // and the limits apply to the velocity loops' accelerations.
+    CascadeConfig cascade;
+    // Follow a motion profile to the target (setpoint plus feedforward)
+    // instead of handing the controllers the whole jump at once.
+    bool profiled = false;
+    ProfileLimits profile;
+};
+
+// Step-response scores for one axis. Times are in simulated seconds and are
+// -1 when the response never got there within the scenario duration.
+struct AxisMetrics {
+    float ise = 0.0f, iae = 0.0f, itae = 0.0f;
+    float overshoot = 0.0f; // fraction of the initial error, 0.1 = 10%
+    float riseTime = -1.0f; // 10% -> 90% of the way to the target
+    float settlingTime = -1.0f;
+};
+
+struct RunResult {
+    Gains gains;
+    AxisMetrics translation, rotation;
+    bool diverged = false;
+    // Cut short by Scenario::skipSaturated; the metrics are incomplete.
+    bool saturated = false;
+};
+
+// Runs one scenario through BasicSimulation<backend>::step and scores it.
+RunResult evaluateGains(const Gains& gains, const Scenario& scenario);
+
+// Single number to rank runs by: translation + rotation ITAE, inf if diverged
+// or cut short for saturating.
+float runCost(const RunResult& result);
+
+// Evaluates every candidate across the pool; results keep the input order.
+std::vector<RunResult> runSweep(const std::vector<Gains>& candidates, const Scenario& scenario, ThreadPool& pool);
+
+// Evenly spaced (P, I, D) triples: the cartesian product of the three ranges.
+std::vector<std::array<float, 3>> makeTripleGrid(const std::array<float, 3>& lo, const std::array<float, 3>& hi, const std::array<int, 3>& counts);
+
+// Every translation triple paired with every rotation triple.
+std::vector<Gains> makeGainGrid(const std::vector<std::array<float, 3>>& move, const std::vector<std::array<float, 3>>& turn);
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// What one controller did on one tick: its error, each term's contribution
+// and their sum (the value handed to updatePose).
+struct PIDTerms {
+    float error, p, i, d, output;
+};
+
+struct SimTerms {
+    PIDTerms x, y, r;
+};
+
+namespace telemetry {
+
+// One float per channel per sim tick.
+enum Channel {
+    XError, XP, XI, XD, XOutput,
+    YError, YP, YI, YD, YOutput,
+    RError, RP, RI, RD, ROutput,
+    PoseX, PoseY, PoseR,
+    kChannels
+};
+
+const char* channelName(int channel);
+
+// Each pyramid level summarizes blocks kFanout times bigger than the last.
+constexpr int kFanout = 4;
+constexpr int kFanoutShift = 2;
+
+}
+
+// Fixed-size history of every telemetry channel, written by the sim thread
+// and read by the renderer with no locks. On top of the raw samples it keeps
+// a min/max pyramid (blocks of 4, 16, 64, ... samples) that the writer
+// updates as it goes, so the min/max over any span costs a handful of reads
+// no matter how long the span is. That's what lets a plot of a million
+// samples draw in constant time per pixel column.
+//
+// Slots are relaxed atomics: the reader may see a slot the writer is about
+// to overwrite, which only matters for the oldest samples, never a torn or
+// undefined value. written() is the release/acquire edge.
+class TelemetryRing {
+public:
+    // capacity is rounded up to a power of two.
+    explicit TelemetryRing(size_t capacity);
+
+    TelemetryRing(const TelemetryRing&) = delete;
+    TelemetryRing& operator=(const TelemetryRing&) = delete;
+
+    // Sim thread only. One value per telemetry::Channel.
+    void push(const float sample[telemetry::kChannels]);
+
+    // Total samples ever pushed; sample n lives until n + capacity() is pushed.
+    uint64_t written() const { return head.load(std::memory_order_acquire); }
+    size_t capacity() const { return size; }
+
+    float sample(int channel, uint64_t n) const {
+        return raw[channel * size + (n & mask)].load(std::memory_order_relaxed);
+    }
+
+    // Min and max of samples [begin, end) of one channel, clamped to what is
+    // still in the ring. Longer spans snap outward to whole pyramid blocks, so
+    // neighbouring spans may overlap a little but never skip a spike.
+    void range(int channel, uint64_t begin, uint64_t end, float& lo, float& hi) const;
+
+private:
+    struct Level {
+        int shift;   // block = 1 << shift samples
+        size_t mask; // blocks kept - 1
+        std::unique_ptr<std::atomic<float>[]> lo, hi;
+    };
+
+    size_t size, mask;
+    std::unique_ptr<std::atomic<float>[]> raw;
+    std::vector<Level> levels;
+    std::atomic<uint64_t> head{0};
+};
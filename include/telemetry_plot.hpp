@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include "imgui.h"
+#include "telemetry.hpp"
+
+// Plots the last `samples` ticks of some telemetry channels, stacked in one
+// box the width of the window. Each pixel column is a single min/max bar
+// from the ring's pyramid, so cost depends on the plot's width, not on how
+// much history it covers. Short histories just draw the samples as lines.
+inline void PlotTelemetry(const char* label, const TelemetryRing& ring, const int* channels,
+                          const ImVec4* colors, int count, uint64_t samples, float height) {
+    ImGui::TextUnformatted(label);
+    for (int k = 0; k < count; k++) {
+        ImGui::SameLine();
+        ImGui::TextColored(colors[k], "%s", telemetry::channelName(channels[k]));
+    }
+
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    float width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+    ImGui::Dummy(ImVec2(width, height));
+
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    ImVec2 corner(origin.x + width, origin.y + height);
+    draw->AddRectFilled(origin, corner, IM_COL32(20, 20, 20, 255));
+    draw->AddRect(origin, corner, IM_COL32(90, 90, 90, 255));
+
+    uint64_t written = ring.written();
+    samples = std::min<uint64_t>(samples, std::min<uint64_t>(written, ring.capacity()));
+    if (samples < 2) return;
+    uint64_t begin = written - samples;
+
+    // Shared vertical scale, from one pyramid query per channel.
+    float lo = 0.0f, hi = 0.0f;
+    for (int k = 0; k < count; k++) {
+        float cLo, cHi;
+        ring.range(channels[k], begin, written, cLo, cHi);
+        lo = (k == 0) ? cLo : std::min(lo, cLo);
+        hi = (k == 0) ? cHi : std::max(hi, cHi);
+    }
+    if (hi - lo < 1e-6f) {
+        lo -= 0.5f;
+        hi += 0.5f;
+    }
+    auto toY = [&](float v) { return corner.y - (v - lo) / (hi - lo) * height; };
+
+    if (lo < 0.0f && hi > 0.0f) {
+        draw->AddLine(ImVec2(origin.x, toY(0.0f)), ImVec2(corner.x, toY(0.0f)), IM_COL32(70, 70, 70, 255));
+    }
+
+    int columns = (int)width;
+    for (int k = 0; k < count; k++) {
+        ImU32 color = ImGui::GetColorU32(colors[k]);
+
+        if (samples <= (uint64_t)columns) {
+            ImVec2 prev(origin.x, toY(ring.sample(channels[k], begin)));
+            for (uint64_t i = 1; i < samples; i++) {
+                ImVec2 next(origin.x + width * i / (samples - 1), toY(ring.sample(channels[k], begin + i)));
+                draw->AddLine(prev, next, color);
+                prev = next;
+            }
+            continue;
+        }
+
+        float prevLo = 0.0f, prevHi = 0.0f;
+        for (int c = 0; c < columns; c++) {
+            uint64_t b = begin + samples * c / columns;
+            uint64_t e = begin + samples * (c + 1) / columns;
+            float cLo, cHi;
+            ring.range(channels[k], b, e, cLo, cHi);
+
+            // Reach back to the previous bar so the trace stays connected.
+            float yLo = cLo, yHi = cHi;
+            if (c > 0) {
+                yLo = std::min(yLo, prevHi);
+                yHi = std::max(yHi, prevLo);
+            }
+            float x = origin.x + c + 0.5f;
+            draw->AddLine(ImVec2(x, toY(yLo)), ImVec2(x, toY(yHi) - 1.0f), color);
+            prevLo = cLo;
+            prevHi = cHi;
+        }
+    }
+
+    char text[32];
+    snprintf(text, sizeof(text), "%.3g", hi);
+    draw->AddText(ImVec2(origin.x + 3.0f, origin.y + 1.0f), IM_COL32(160, 160, 160, 255), text);
+    snprintf(text, sizeof(text), "%.3g", lo);
+    draw->AddText(ImVec2(origin.x + 3.0f, corner.y - 15.0f), IM_COL32(160, 160, 160, 255), text);
+}
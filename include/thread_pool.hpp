@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for fanning independent sim runs across cores.
+// The calling thread joins in on every parallelFor, so a pool of N uses N
+// threads total.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+
+    const std::function<void(size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    std::atomic<size_t> next{0};
+    size_t busy = 0;
+    size_t generation = 0;
+    bool stopping = false;
+
+    void drain() {
+        size_t i;
+        while ((i = next.fetch_add(1, std::memory_order_relaxed)) < jobCount) {
+            (*job)(i);
+        }
+    }
+
+    void workerLoop() {
+        size_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            drain();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy == 0) done.notify_one();
+        }
+    }
+
+public:
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency()) {
+        if (threads == 0) threads = 1;
+        for (unsigned i = 1; i < threads; i++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : workers) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return (unsigned)workers.size() + 1; }
+
+    // Calls fn(i) for every i in [0, count) and blocks until all have returned.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+        if (count == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            jobCount = count;
+            next.store(0, std::memory_order_relaxed);
+            busy = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+        drain();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busy == 0; });
+        job = nullptr;
+    }
+};
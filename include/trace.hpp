@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "motion_profile.hpp"
+#include "sim.hpp"
+
+// Binary trace of a sim run, enough to replay it bit-exactly:
+//
+//   header:  "PIDTRACE" magic, uint32 version, float startX, float startY
+//   records: one tag byte followed by packed floats
+//
+// Every number, header included, is little-endian IEEE-754 on every host:
+// the writer and reader convert explicitly rather than copying raw structs,
+// so a trace recorded on one machine replays on any other.
+//     'G'  moveP moveI moveD turnP turnI turnD   whenever the gains change
+//     'C'  enabled outerEvery innerEvery moveVel[3] turnVel[3]
+//                                                whenever the cascade changes
+//     'P'  profiled maxVel maxAccel maxJerk      whenever either changes
+//     'T'  targetX targetY dt x y r              once per tick, pose after it
+//
+// Settings only show up when they change, so a tick costs 25 bytes. Version
+// 1 traces have no 'C' or 'P' records and version 2 none of 'P'; they
+// replay as direct control and unprofiled targets.
+namespace trace {
+
+constexpr char kMagic[8] = {'P', 'I', 'D', 'T', 'R', 'A', 'C', 'E'};
+constexpr uint32_t kVersion = 3;
+constexpr size_t kHeaderSize = sizeof(kMagic) + sizeof(uint32_t) + 2 * sizeof(float);
+constexpr uint8_t kGains = 'G';
+constexpr uint8_t kTick = 'T';
+constexpr uint8_t kCascade = 'C';
+constexpr uint8_t kProfile = 'P';
+constexpr size_t kGainsSize = 1 + 6 * sizeof(float);
+constexpr size_t kTickSize = 1 + 6 * sizeof(float);
+constexpr size_t kCascadeSize = 1 + 9 * sizeof(float);
+constexpr size_t kProfileSize = 1 + 4 * sizeof(float);
+
+}
+
+struct TraceTick {
+    float targetX, targetY, dt;
+    float x, y, r;
+};
+
+class TraceWriter {
+public:
+    TraceWriter() = default;
+    ~TraceWriter() { close(); }
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    bool open(const std::string& path, float startX, float startY);
+    void close();
+    bool isOpen() const { return file != nullptr; }
+
+    // Only writes a record when the gains differ from the last ones written.
+    void gains(const float move[3], const float turn[3]);
+    // Same for the cascade. Call it every time the sim applies one, ticks or
+    // not: toggling it resets the inner loops, so no change can be skipped.
+    void cascade(const CascadeConfig& config);
+    // And the motion profile: replay rebuilds the same tables from the
+    // targets and poses in the ticks, so the limits are all it needs.
+    void profile(bool profiled, const ProfileLimits& limits);
+    void tick(const TraceTick& t);
+
+private:
+    FILE* file = nullptr;
+    float lastGains[6];
+    float lastCascade[9];
+    float lastProfile[4];
+    bool haveGains = false;
+    bool haveCascade = false;
+    bool haveProfile = false;
+};
+
+// Read-only memory map of a whole file. Pages are only faulted in as they are
+// touched, so multi-hour traces don't need to fit in RAM.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+};
+
+struct ReplayResult {
+    bool valid = false;      // header and records parsed cleanly
+    uint64_t ticks = 0;
+    uint64_t mismatches = 0; // ticks whose pose differs from the recording
+    uint64_t firstMismatch = 0;
+    double simSeconds = 0.0;
+};
+
+// Feeds a trace back through Simulation::step, with the recorded gains,
+// cascade settings and motion profiles, and compares every pose with the recorded one bit for bit.
+ReplayResult replayTrace(const uint8_t* data, size_t size);
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+
+// Single-producer/single-consumer hand-off of the latest value of T, without
+// locks. The writer fills writeBuffer() and publish()es it; the reader calls
+// update() and then looks at readBuffer(). Neither side ever waits, and the
+// reader always sees a complete value, never one the writer is halfway into.
+template <typename T>
+class TripleBuffer {
+private:
+    static constexpr unsigned kIndexMask = 3;
+    static constexpr unsigned kFresh = 4;
+
+    struct alignas(64) Slot {
+        T value;
+    };
+
+    Slot slots[3];
+    // Index of the spare slot, plus kFresh when it holds an unread publish.
+    alignas(64) std::atomic<unsigned> spare{1};
+    alignas(64) unsigned writeIndex = 0;
+    alignas(64) unsigned readIndex = 2;
+
+public:
+    TripleBuffer() = default;
+    explicit TripleBuffer(const T& initial) {
+        for (Slot& s : slots) s.value = initial;
+    }
+
+    // Writer side.
+    T& writeBuffer() { return slots[writeIndex].value; }
+
+    void publish() {
+        unsigned old = spare.exchange(writeIndex | kFresh, std::memory_order_acq_rel);
+        writeIndex = old & kIndexMask;
+    }
+
+    void write(const T& value) {
+        writeBuffer() = value;
+        publish();
+    }
+
+    // Reader side. Returns true if a newer value was picked up.
+    bool update() {
+        if (!(spare.load(std::memory_order_relaxed) & kFresh)) return false;
+        unsigned old = spare.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = old & kIndexMask;
+        return true;
+    }
+
+    const T& readBuffer() const { return slots[readIndex].value; }
+};
@@ -6,13 +6,34 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
-#include "pid.hpp"
-#include "robot.hpp"
+#include "sim_thread.hpp"
+#include "motion_profile.hpp"
+#include "fixed_step.hpp"
+#include "autotune.hpp"
+#include "robot_renderer.hpp"
 #include "1draycast.hpp"
 #include "circle.hpp"
+#include "fleet_sim.hpp"
+#include "instanced_renderer.hpp"
+#include "shader_program.hpp"
+#include "telemetry_plot.hpp"
+#include "profiler.hpp"
+#include "gpu_timer.hpp"
+#ifdef PIDSIM_OFFSCREEN
+#include <cerrno>
+#include <sys/stat.h>
+#include "offscreen.hpp"
+#endif
 
 // Window Constants
 const unsigned int WIDTH = 750; 
@@ -26,16 +47,87 @@ const unsigned int HEIGHT2 = 750;
 struct TuningState {
     float moveGains[3] = {1.0f, 0.0f, 0.00f};
     float turnGains[3] = {1.0f, 0.0f, 0.00f};
-    float time = 0.01f;
+    float time = 0.01f; // fixed physics/PID step, independent of frame rate
+    bool gpuRaycast = false;
+    float autotuneLatency = 0.02f; // seconds
+    AutotuneResult lastTune{};
+    std::string tuneStatus;
+    int plotAxis = 0;       // 0 = x, 1 = y, 2 = rotation
+    int plotHistory = 1000; // ticks
+    bool showProfiler = false;
+    std::string profileStatus;
+    int speedMode = 0;          // 0 = real time, 1 = speedFactor x, 2 = as fast as possible
+    float speedFactor = 10.0f;
+    float measuredSpeed = 1.0f; // sim seconds per real second, lately
+    int displayHz = 0;          // render loop cap, 0 = none
+    bool vsync = true;
+    CascadeConfig cascade;
+    bool clickTarget = false;   // target stays put until the next click
+    float clickX = 0.0f, clickY = 0.0f;
+    bool profiled = false;      // reach each click along a motion profile
+    ProfileLimits profile;
 };
 
-GLuint CreateShaderProgram() {
+// Sim seconds per real second for SimInput::speed; 0 = flat out.
+float SimSpeed(const TuningState& state) {
+    if (state.speedMode == 2) return 0.0f;
+    return state.speedMode == 1 ? state.speedFactor : 1.0f;
+}
+
+SimInput MakeSimInput(const TuningState& state, float targetX, float targetY) {
+    SimInput in;
+    in.targetX = targetX;
+    in.targetY = targetY;
+    for (int i = 0; i < 3; i++) {
+        in.moveGains[i] = state.moveGains[i];
+        in.turnGains[i] = state.turnGains[i];
+    }
+    in.dt = state.time;
+    in.speed = SimSpeed(state);
+    in.cascade = state.cascade;
+    // Following the cursor would restart the profile every frame it moves.
+    in.profiled = state.clickTarget && state.profiled;
+    in.profile = state.profile;
+    return in;
+}
+
+// The PID sliders' ranges; ApplyTuning won't set gains the panel can't show.
+constexpr float kMaxGain[3] = {10.0f, 2.0f, 10.0f};
+
+// Copies an auto-tune suggestion into the sliders if it passed its scenario
+// check and fits their ranges. Returns what happened, for the panel.
+std::string ApplyTuning(TuningState& state, const TuningSuggestion& s) {
+    if (!state.lastTune.translation.ok || !state.lastTune.rotation.ok) return "Relay test failed, gains left alone.";
+    char text[256];
+    if (!s.usable) {
+        snprintf(text, sizeof(text), "Not applied: the suggestion %s on the default scenario "
+                 "(move P %.3g I %.3g D %.3g, turn P %.3g I %.3g D %.3g).",
+                 s.problem, s.move[0], s.move[1], s.move[2], s.turn[0], s.turn[1], s.turn[2]);
+        return text;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (s.move[i] > kMaxGain[i] || s.turn[i] > kMaxGain[i]) {
+            snprintf(text, sizeof(text), "Not applied: outside the slider ranges "
+                     "(move P %.3g I %.3g D %.3g, turn P %.3g I %.3g D %.3g).",
+                     s.move[0], s.move[1], s.move[2], s.turn[0], s.turn[1], s.turn[2]);
+            return text;
+        }
+    }
+    std::copy(s.move, s.move + 3, state.moveGains);
+    std::copy(s.turn, s.turn + 3, state.turnGains);
+    snprintf(text, sizeof(text), "Applied, with Kp backed off to %.0f%% of the rule's.", s.kpScale * 100.0f);
+    return text;
+}
+
+ShaderProgram CreateShaderProgram() {
     const char* vertexShaderSource = R"(
         #version 330 core
         layout(location = 0) in vec3 aPos;
         uniform mat4 model;
-        uniform mat4 view; 
-        uniform mat4 projection; 
+        layout(std140) uniform Camera {
+            mat4 view;
+            mat4 projection;
+        };
         void main() {
             gl_Position = projection * view * model * vec4(aPos, 1.0);
         }
@@ -50,26 +142,10 @@ GLuint CreateShaderProgram() {
         }
     )";
 
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return shaderProgram;
+    return ShaderProgram("map", vertexShaderSource, fragmentShaderSource);
 }
 
-GLuint CreateRenderRayProgram() {
+ShaderProgram CreateRenderRayProgram() {
     const char* vertexShaderSource = R"(
         #version 330 core
         layout (location = 0) in vec3 aPos;   // Ray position (x, y, z)
@@ -77,13 +153,9 @@ GLuint CreateRenderRayProgram() {
 
         out vec3 ourColor; 
 
-        uniform mat4 model;
-        uniform mat4 view; 
-        uniform mat4 projection; 
-
         void main() {
-            // Standard transformation
-            gl_Position = projection * view * model * vec4(aPos, 1.0);
+            // Columns are built straight in NDC, no transform needed
+            gl_Position = vec4(aPos, 1.0);
             
             // Pass the vertex color to the fragment shader
             ourColor = aColor;
@@ -101,85 +173,543 @@ GLuint CreateRenderRayProgram() {
         }
     )";
 
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
+    return ShaderProgram("robot view", vertexShaderSource, fragmentShaderSource);
+}
+
+// Robot View done entirely on the GPU: a full-screen triangle whose fragment
+// shader intersects one ray per pixel column with the field walls, matching
+// Raycaster::updateAndDraw's math.
+ShaderProgram CreateRaycastProgram() {
+    const char* vertexShaderSource = R"(
+        #version 330 core
+        void main() {
+            // Full-screen triangle from the vertex index, no buffers needed
+            vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+            gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+        }
+    )";
+
+    const char* fragmentShaderSource = R"(
+        #version 330 core
+        out vec4 FragColor;
+
+        uniform vec3 uPose;      // robot x, y, heading
+        uniform vec2 uLimits;    // walls at +-limitX, +-limitY
+        uniform vec2 uOrigin;    // viewport corner, pixels
+        uniform vec2 uViewport;  // viewport size, pixels
+        uniform float uFov;      // radians
+        uniform float uFocal;
+        uniform float uColumns;
+
+        void main() {
+            vec2 ndc = (gl_FragCoord.xy - uOrigin) / uViewport * 2.0 - 1.0;
+            float column = floor((ndc.x * 0.5 + 0.5) * uColumns);
+
+            float center = uPose.z + 1.57079;
+            float angle = center - uFov * 0.5 + (column / uColumns) * uFov;
+            vec2 dir = vec2(cos(angle), sin(angle));
+
+            float tX = ((dir.x > 0.0) ? (uLimits.x - uPose.x) : (-uLimits.x - uPose.x)) / dir.x;
+            float tY = ((dir.y > 0.0) ? (uLimits.y - uPose.y) : (-uLimits.y - uPose.y)) / dir.y;
+
+            float dist;
+            vec3 color;
+            if (tX < tY) {
+                dist = tX;
+                color = vec3(0.7, 0.3, 0.3);
+            } else {
+                dist = tY;
+                color = vec3(0.3, 0.4, 0.6);
+            }
+
+            // Undo the fisheye, same as the CPU path
+            dist *= cos(angle - center);
+            float h = min(uFocal / (dist + 0.001), 1.0);
+
+            if (abs(ndc.y) > h) discard;
+            FragColor = vec4(color, 1.0);
+        }
+    )";
+
+    return ShaderProgram("gpu raycast", vertexShaderSource, fragmentShaderSource);
+}
+
+
+ShaderProgram CreateInstancedProgram() {
+    const char* vertexShaderSource = R"(
+        #version 330 core
+        layout (location = 0) in vec3 aPos;
+        layout (location = 1) in vec4 iPose;  // x, y, angle, scale
+        layout (location = 2) in vec4 iColor;
+
+        out vec4 ourColor;
+
+        layout(std140) uniform Camera {
+            mat4 view;
+            mat4 projection;
+        };
+
+        void main() {
+            float c = cos(iPose.z);
+            float s = sin(iPose.z);
+            vec2 p = aPos.xy * iPose.w;
+            vec2 world = vec2(c * p.x - s * p.y, s * p.x + c * p.y) + iPose.xy;
+            gl_Position = projection * view * vec4(world, aPos.z, 1.0);
+            ourColor = iColor;
+        }
+    )";
 
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+    const char* fragmentShaderSource = R"(
+        #version 330 core
+        out vec4 FragColor;
+        in vec4 ourColor;
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+        void main() {
+            FragColor = ourColor;
+        }
+    )";
 
-    return shaderProgram;
+    return ShaderProgram("instanced", vertexShaderSource, fragmentShaderSource);
 }
 
+// Every program plus the map camera, in one place so they can all be freed
+// while a context is still current.
+struct Shaders {
+    ShaderProgram map = CreateShaderProgram();
+    ShaderProgram ray = CreateRenderRayProgram();
+    ShaderProgram raycast = CreateRaycastProgram();
+    ShaderProgram instanced = CreateInstancedProgram();
+    CameraBuffer camera;
+
+    bool ok() const { return map.ok() && ray.ok() && raycast.ok() && instanced.ok(); }
+};
+
+// Rolling per-stage timings, grouped by thread/GPU, plus the trace dump.
+void RenderProfilerOverlay(TuningState& state, const Profiler& profiler) {
+    ImGui::Begin("Profiler", &state.showProfiler, ImGuiWindowFlags_AlwaysAutoResize);
+
+    float frameMs = profiler.frameAverageMs();
+    ImGui::Text("Frame: %.2f ms (%.0f fps)", frameMs, frameMs > 0.0f ? 1000.0f / frameMs : 0.0f);
+
+    for (int t = 0; t < Profiler::kTracks; t++) {
+        ImGui::Separator();
+        ImGui::TextUnformatted(Profiler::trackName((Profiler::Track)t));
+        for (const Profiler::Stage& stage : profiler.stages()) {
+            if (stage.track != t) continue;
+            char label[64];
+            snprintf(label, sizeof(label), "%.3f ms", stage.averageMs);
+            ImGui::ProgressBar(frameMs > 0.0f ? stage.averageMs / frameMs : 0.0f, ImVec2(140.0f, 0.0f), label);
+            ImGui::SameLine();
+            ImGui::TextUnformatted(stage.name);
+        }
+    }
+
+    ImGui::Separator();
+    if (ImGui::Button("Save Chrome trace")) {
+        const char* path = "pid_sim_trace.json";
+        state.profileStatus = profiler.writeChromeTrace(path)
+            ? std::string("wrote ") + path + " (open in chrome://tracing)"
+            : std::string("could not write ") + path;
+    }
+    if (!state.profileStatus.empty()) ImGui::TextUnformatted(state.profileStatus.c_str());
 
-void RenderUI(TuningState& state, PID& px, PID& py, PID& pr, const SwerveDrive& robot) {
+    ImGui::End();
+}
+
+void RenderUI(TuningState& state, const SimSnapshot& snapshot, const TelemetryRing& telemetryRing, const Profiler& profiler) {
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
+#ifdef IMGUI_HAS_DOCK
+    // Panels can dock to the window's edges; the middle stays see-through so
+    // the map and Robot View show under it.
+    if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_DockingEnable) {
+#if IMGUI_VERSION_NUM >= 19100
+        ImGui::DockSpaceOverViewport(0, ImGui::GetMainViewport(), ImGuiDockNodeFlags_PassthruCentralNode);
+#else
+        ImGui::DockSpaceOverViewport(ImGui::GetMainViewport(), ImGuiDockNodeFlags_PassthruCentralNode);
+#endif
+    }
+#endif
+
     ImGui::Begin("PID Controller Tuning");
     ImGui::SetWindowFontScale(1.2f);
 
     if (ImGui::CollapsingHeader("Translation PID")) {
-        ImGui::SliderFloat("Move P", &state.moveGains[0], 0.0f, 10.0f);
-        ImGui::SliderFloat("Move I", &state.moveGains[1], 0.0f, 2.0f);
-        ImGui::SliderFloat("Move D", &state.moveGains[2], 0.0f, 10.0f);
-        px.P = py.P = state.moveGains[0];
-        px.I = py.I = state.moveGains[1];
-        px.D = py.D = state.moveGains[2];
+        ImGui::SliderFloat("Move P", &state.moveGains[0], 0.0f, kMaxGain[0]);
+        ImGui::SliderFloat("Move I", &state.moveGains[1], 0.0f, kMaxGain[1]);
+        ImGui::SliderFloat("Move D", &state.moveGains[2], 0.0f, kMaxGain[2]);
     }
 
     if (ImGui::CollapsingHeader("Rotation PID")) {
-        ImGui::SliderFloat("Turn P", &state.turnGains[0], 0.0f, 10.0f);
-        ImGui::SliderFloat("Turn I", &state.turnGains[1], 0.0f, 2.0f);
-        ImGui::SliderFloat("Turn D", &state.turnGains[2], 0.0f, 10.0f);
-        pr.P = state.turnGains[0];
-        pr.I = state.turnGains[1];
-        pr.D = state.turnGains[2];
+        ImGui::SliderFloat("Turn P", &state.turnGains[0], 0.0f, kMaxGain[0]);
+        ImGui::SliderFloat("Turn I", &state.turnGains[1], 0.0f, kMaxGain[1]);
+        ImGui::SliderFloat("Turn D", &state.turnGains[2], 0.0f, kMaxGain[2]);
     }
 
+    if (ImGui::CollapsingHeader("Target")) {
+        ImGui::Checkbox("Click to set target", &state.clickTarget);
+        ImGui::Checkbox("Motion profile", &state.profiled);
+        ImGui::TextDisabled("Clicks only: setpoint plus feedforward instead of the whole jump.");
+        ImGui::SliderFloat("Max velocity", &state.profile.maxVel, 0.1f, 5.0f);
+        ImGui::SliderFloat("Max accel", &state.profile.maxAccel, 0.1f, 50.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
+        ImGui::SliderFloat("Max jerk", &state.profile.maxJerk, 0.0f, 1000.0f, state.profile.maxJerk > 0.0f ? "%.0f" : "off (trapezoid)");
+    }
+
+    if (ImGui::CollapsingHeader("Cascaded control")) {
+        CascadeConfig& c = state.cascade;
+        ImGui::Checkbox("Position loop over velocity loop", &c.enabled);
+        ImGui::TextDisabled("The PIDs above then output a velocity setpoint.");
+        ImGui::SliderInt("Position every", &c.outerEvery, 1, 100, "%d ticks");
+        ImGui::SliderInt("Velocity every", &c.innerEvery, 1, 20, "%d ticks");
+        ImGui::Text("Position loop %.0f Hz, velocity loop %.0f Hz",
+                    1.0f / (state.time * c.outerEvery), 1.0f / (state.time * c.innerEvery));
+        ImGui::SliderFloat("Move vel P", &c.moveVelGains[0], 0.0f, 1000.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
+        ImGui::SliderFloat("Move vel I", &c.moveVelGains[1], 0.0f, 100.0f);
+        ImGui::SliderFloat("Move vel D", &c.moveVelGains[2], 0.0f, 10.0f);
+        ImGui::SliderFloat("Turn vel P", &c.turnVelGains[0], 0.0f, 1000.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
+        ImGui::SliderFloat("Turn vel I", &c.turnVelGains[1], 0.0f, 100.0f);
+        ImGui::SliderFloat("Turn vel D", &c.turnVelGains[2], 0.0f, 10.0f);
+    }
+
+    if (ImGui::CollapsingHeader("Auto-tune")) {
+        ImGui::SliderFloat("Latency (s)", &state.autotuneLatency, 0.0f, 0.1f, "%.3f");
+        bool zn = ImGui::Button("Ziegler-Nichols");
+        ImGui::SameLine();
+        bool tl = ImGui::Button("Tyreus-Luyben");
+
+        if (zn || tl) {
+            RelayConfig config;
+            config.dt = state.time;
+            config.latency = state.autotuneLatency;
+            std::copy(kMaxGain, kMaxGain + 3, config.maxGain);
+            Scenario scenario;
+            scenario.dt = state.time;
+            state.lastTune = autotune(config, scenario);
+            const TuningSuggestion& s = zn ? state.lastTune.zieglerNichols : state.lastTune.tyreusLuyben;
+            state.tuneStatus = ApplyTuning(state, s);
+        }
+
+        const RelayResult& t = state.lastTune.translation;
+        const RelayResult& r = state.lastTune.rotation;
+        if (t.ok && r.ok) {
+            ImGui::Text("Move Ku: %.1f, Pu: %.3f s", t.ultimateGain, t.ultimatePeriod);
+            ImGui::Text("Turn Ku: %.1f, Pu: %.3f s", r.ultimateGain, r.ultimatePeriod);
+        }
+        if (!state.tuneStatus.empty()) ImGui::TextWrapped("%s", state.tuneStatus.c_str());
+    }
+
+    if (ImGui::CollapsingHeader("Telemetry")) {
+        const char* axes[] = {"X", "Y", "Rotation"};
+        ImGui::Combo("Axis", &state.plotAxis, axes, 3);
+        ImGui::SliderInt("History", &state.plotHistory, 100, (int)telemetryRing.capacity(), "%d ticks", ImGuiSliderFlags_Logarithmic);
+
+        // Channels are laid out error, P, I, D, output per axis.
+        int first = telemetry::XError + state.plotAxis * (telemetry::YError - telemetry::XError);
+        int error[] = {first};
+        int terms[] = {first + 1, first + 2, first + 3, first + 4};
+        int pose[] = {telemetry::PoseX + state.plotAxis};
+        ImVec4 white(0.9f, 0.9f, 0.9f, 1.0f);
+        ImVec4 termColors[] = {
+            ImVec4(0.9f, 0.4f, 0.3f, 1.0f), ImVec4(0.4f, 0.8f, 0.4f, 1.0f),
+            ImVec4(0.4f, 0.6f, 1.0f, 1.0f), white,
+        };
+
+        PlotTelemetry("Error", telemetryRing, error, &white, 1, state.plotHistory, 80.0f);
+        PlotTelemetry("Output", telemetryRing, terms, termColors, 4, state.plotHistory, 120.0f);
+        PlotTelemetry("Pose", telemetryRing, pose, &white, 1, state.plotHistory, 80.0f);
+    }
+
+    if (ImGui::CollapsingHeader("Speed")) {
+        ImGui::RadioButton("Real time", &state.speedMode, 0);
+        ImGui::SameLine();
+        ImGui::RadioButton("Fast forward", &state.speedMode, 1);
+        ImGui::SameLine();
+        ImGui::RadioButton("Max", &state.speedMode, 2);
+        if (state.speedMode == 1) {
+            ImGui::SliderFloat("Speed", &state.speedFactor, 1.0f, 1000.0f, "%.0fx", ImGuiSliderFlags_Logarithmic);
+        }
+        ImGui::Text("Sim time: %.1f s (%.1fx real time)", snapshot.simTime, state.measuredSpeed);
+
+        ImGui::SliderInt("Display cap", &state.displayHz, 0, 240, state.displayHz > 0 ? "%d Hz" : "off");
+        ImGui::Checkbox("Vsync", &state.vsync);
+    }
+
+    ImGui::Checkbox("GPU raycast (Robot View)", &state.gpuRaycast);
+    ImGui::Checkbox("Show profiler", &state.showProfiler);
+
     ImGui::Separator();
-    ImGui::SliderFloat("Step Time", &state.time, 0.01f, 0.1f);
-    ImGui::Text("Robot X: %.3f, Y: %.3f", robot.x, robot.y);
-    ImGui::Text("Heading: %.3f rad", robot.r);
+    ImGui::SliderFloat("Step Time", &state.time, 0.001f, 0.1f, "%.3f s");
+    ImGui::Text("Physics rate: %.0f Hz", 1.0f / state.time);
+    ImGui::Text("Robot X: %.3f, Y: %.3f", snapshot.robot.x, snapshot.robot.y);
+    ImGui::Text("Heading: %.3f rad", snapshot.robot.r);
+    ImGui::Text("Sim tick: %llu", (unsigned long long)snapshot.tick);
     
     ImGui::End();
+
+    if (state.showProfiler) RenderProfilerOverlay(state, profiler);
     ImGui::Render();
 }
 
-void RenderMapWindow(GLFWwindow* window, GLuint shader, SwerveDrive& robot, CircleIndicator& indicator) {
-    
-    glfwMakeContextCurrent(window);
+// A rectangle of the framebuffer, in pixels from the bottom left.
+struct Viewport {
+    int x, y, width, height;
+};
+
+// Confines drawing, clears included, to one pane of a shared window.
+void UsePane(const Viewport& pane) {
+    glViewport(pane.x, pane.y, pane.width, pane.height);
+    glScissor(pane.x, pane.y, pane.width, pane.height);
+    glEnable(GL_SCISSOR_TEST);
+}
+
+// Map contents into whatever framebuffer is bound (window or offscreen).
+void DrawMap(const ShaderProgram& shader, SwerveDriveRenderer& robotRenderer, const SwerveDrive& robot, CircleIndicator& indicator) {
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glm::mat4 projection = glm::ortho(-aspect_ratio, aspect_ratio, -1.0f, 1.0f, -1.0f, 1.0f);
-    glm::mat4 view = glm::mat4(1.0f);
-    
-    glUseProgram(shader);
-    glUniformMatrix4fv(glGetUniformLocation(shader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-    glUniformMatrix4fv(glGetUniformLocation(shader, "view"), 1, GL_FALSE, glm::value_ptr(view));
-
-    robot.draw(shader);
+    robotRenderer.draw(shader, robot);
     indicator.draw(shader);
+}
+
+// Robot View contents into `view` of the bound framebuffer, which must
+// already be the current viewport.
+void DrawRobotView(Raycaster& raycaster, const Shaders& shaders, bool gpuRaycast, const SwerveDrive& robot, float targetX, float targetY, const Viewport& view) {
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // The GPU path only knows the box walls.
+    if (gpuRaycast && !raycaster.hasField()) {
+        raycaster.drawGpu(shaders.raycast, robot.x, robot.y, robot.r, view.x, view.y, view.width, view.height);
+    } else {
+        raycaster.updateAndDraw(shaders.ray, robot.x, robot.y, robot.r);
+    }
+    raycaster.drawCursor(shaders.ray, robot.x, robot.y, robot.r, targetX, targetY);
+}
+
+// --fleet version of the map: every robot plus the target in two draw calls.
+void DrawFleetMap(const ShaderProgram& instancedShader, InstancedRenderer& instanced, const FleetSim& fleet, const SwerveDrive& robot, const CircleIndicator& indicator) {
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    instanced.clear();
+    for (size_t i = 0; i < fleet.size(); i++) {
+        instanced.addRobot(fleet.fleet.x[i], fleet.fleet.y[i], fleet.fleet.r[i], glm::vec4(0.3f, 0.6f, 0.9f, 0.25f));
+    }
+    instanced.addRobot(robot.x, robot.y, robot.r, glm::vec4(0.0f, 0.0f, 0.8f, 1.0f));
+    instanced.addMarker(indicator.x, indicator.y, 0.02f, glm::vec4(1.0f));
+    instanced.draw(instancedShader);
+}
+
+// Whichever map this session shows; fleet and instanced are null unless
+// running with --fleet.
+void DrawMapScene(const Shaders& shaders, SwerveDriveRenderer& robotRenderer, InstancedRenderer* instanced, const FleetSim* fleet, const SwerveDrive& robot, CircleIndicator& indicator) {
+    if (fleet) {
+        DrawFleetMap(shaders.instanced, *instanced, *fleet, robot, indicator);
+    } else {
+        DrawMap(shaders.map, robotRenderer, robot, indicator);
+    }
+}
+
+// Swapping is left to the caller so it can be timed on its own.
+void RenderMapWindow(GLFWwindow* window, GpuTimer& gpu, const Shaders& shaders, SwerveDriveRenderer& robotRenderer, InstancedRenderer* instanced, const FleetSim* fleet, const SwerveDrive& robot, CircleIndicator& indicator) {
+    
+    glfwMakeContextCurrent(window);
+    gpu.begin("map + ImGui");
+    DrawMapScene(shaders, robotRenderer, instanced, fleet, robot, indicator);
 
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-    glfwSwapBuffers(window);
+    gpu.end();
 }
 
+// Settings for --offscreen, which renders a scripted run to image files
+// instead of opening windows.
+struct OffscreenOptions {
+    const char* dir = nullptr;
+    int frames = 300;
+    int fps = 60;
+    bool raw = false;
+    float targetX = 0.5f, targetY = 0.5f;
+};
+
+#ifdef PIDSIM_OFFSCREEN
+// Chases a fixed target from the origin and saves both views every frame,
+// with no window system at all. Sim time advances 1/fps per frame, so the
+// output is the same however long each frame takes to render.
+int RunOffscreen(const OffscreenOptions& options, const TuningState& state, const Field* field) {
+    OffscreenContext context;
+    if (!context.ok()) {
+        std::cerr << "offscreen: " << context.error() << std::endl;
+        return 1;
+    }
+    if (mkdir(options.dir, 0755) != 0 && errno != EEXIST) {
+        std::cerr << "offscreen: could not create " << options.dir << std::endl;
+        return 1;
+    }
+
+    Shaders shaders;
+    if (!shaders.ok()) return 1;
+    shaders.camera.bind();
+    shaders.camera.update(glm::mat4(1.0f), glm::ortho(-aspect_ratio, aspect_ratio, -1.0f, 1.0f, -1.0f, 1.0f));
+
+    glDisable(GL_DEPTH_TEST);
+    SwerveDriveRenderer robotRenderer(shaders.map);
+    CircleIndicator target(shaders.map, options.targetX, options.targetY);
+    Raycaster raycaster(WIDTH2, shaders.raycast);
+    if (field) raycaster.setField(field);
+
+    FrameTarget mapTarget(WIDTH, HEIGHT);
+    FrameTarget viewTarget(WIDTH2, HEIGHT2);
+    FrameWriter writer(options.raw ? FrameWriter::Raw : FrameWriter::PPM);
+
+    Simulation sim(state.moveGains, state.turnGains);
+    sim.setCascade(state.cascade);
+    ProfileFollower follower;
+    follower.limits = state.profile;
+    FixedStepClock clock(state.time);
+    std::string dir = options.dir;
+
+    for (int frame = 0; frame < options.frames; frame++) {
+        for (int steps = clock.advance(1.0 / options.fps); steps > 0; steps--) {
+            if (state.profiled) {
+                Reference ref = follower.next(options.targetX, options.targetY, sim.robot, state.time);
+                sim.step(options.targetX, options.targetY, state.time, nullptr, &ref);
+            } else {
+                sim.step(options.targetX, options.targetY, state.time);
+            }
+        }
+        SwerveDrive robot = interpolatePose(sim.robot, clock.alpha());
+
+        mapTarget.bind();
+        DrawMap(shaders.map, robotRenderer, robot, target);
+        viewTarget.bind();
+        DrawRobotView(raycaster, shaders, state.gpuRaycast, robot, options.targetX, options.targetY, Viewport{0, 0, (int)WIDTH2, (int)HEIGHT2});
+
+        char name[32];
+        const char* views[] = {"map", "view"};
+        FrameTarget* targets[] = {&mapTarget, &viewTarget};
+        for (int v = 0; v < 2; v++) {
+            if (options.raw) snprintf(name, sizeof(name), "/%s.rgb", views[v]);
+            else snprintf(name, sizeof(name), "/%s_%05d.ppm", views[v], frame);
+
+            std::vector<unsigned char> pixels = writer.buffer();
+            targets[v]->read(pixels);
+            writer.write(dir + name, targets[v]->width, targets[v]->height, std::move(pixels));
+        }
+    }
+
+    writer.flush();
+    if (writer.failures() > 0) {
+        std::cerr << "offscreen: " << writer.failures() << " frames failed to write" << std::endl;
+        return 1;
+    }
+    std::cout << "wrote " << options.frames << " frames of each view to " << dir << std::endl;
+    if (options.raw) {
+        std::cout << "encode with: ffmpeg -f rawvideo -pix_fmt rgb24 -s " << WIDTH << "x" << HEIGHT
+                  << " -r " << options.fps << " -i " << dir << "/map.rgb map.mp4" << std::endl;
+    }
+    return 0;
+}
+#endif
+
+// Waits out the rest of this frame's slot when the loop is capped at `hz`.
+// A slow frame doesn't bank time for the next one.
+void WaitForNextFrame(int hz, double& lastFrame) {
+    double now = SimClockNow();
+    double due = lastFrame + 1.0 / std::max(hz, 1);
+    if (hz > 0 && due > now) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(due - now));
+        lastFrame = due;
+    } else {
+        lastFrame = now;
+    }
+}
+
+// Swap intervals belong to contexts. With two windows only the last swap of
+// the frame waits for vblank, or each frame would cost two refreshes.
+void ApplyVsync(GLFWwindow* window, GLFWwindow* viewWindow, bool vsync) {
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(vsync && window == viewWindow ? 1 : 0);
+    if (viewWindow != window) {
+        glfwMakeContextCurrent(viewWindow);
+        glfwSwapInterval(vsync ? 1 : 0);
+        glfwMakeContextCurrent(window);
+    }
+}
 
+// "a,b,c" into three floats, leaving them alone if it doesn't parse.
+void ParseTriple(const char* text, float out[3]) {
+    float a, b, c;
+    if (sscanf(text, "%f,%f,%f", &a, &b, &c) == 3) {
+        out[0] = a;
+        out[1] = b;
+        out[2] = c;
+    }
+}
 
-int main(void)
+int main(int argc, char** argv)
 {
+    const char* recordPath = nullptr;
+    const char* fieldPath = nullptr;
+    int fleetSize = 0;
+    TuningState state;
+    OffscreenOptions offscreen;
+    bool singleWindow = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordPath = argv[++i];
+        else if (strcmp(argv[i], "--field") == 0 && i + 1 < argc) fieldPath = argv[++i];
+        else if (strcmp(argv[i], "--fleet") == 0 && i + 1 < argc) fleetSize = std::max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--move") == 0 && i + 1 < argc) ParseTriple(argv[++i], state.moveGains);
+        else if (strcmp(argv[i], "--turn") == 0 && i + 1 < argc) ParseTriple(argv[++i], state.turnGains);
+        else if (strcmp(argv[i], "--cascade") == 0 && i + 1 < argc) {
+            CascadeConfig& c = state.cascade;
+            c.enabled = sscanf(argv[++i], "%d,%d", &c.outerEvery, &c.innerEvery) == 2;
+        }
+        else if (strcmp(argv[i], "--move-vel") == 0 && i + 1 < argc) ParseTriple(argv[++i], state.cascade.moveVelGains);
+        else if (strcmp(argv[i], "--turn-vel") == 0 && i + 1 < argc) ParseTriple(argv[++i], state.cascade.turnVelGains);
+        else if (strcmp(argv[i], "--click") == 0) state.clickTarget = true;
+        else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            ProfileLimits& p = state.profile;
+            state.profiled = state.clickTarget = sscanf(argv[++i], "%f,%f,%f", &p.maxVel, &p.maxAccel, &p.maxJerk) >= 2;
+        }
+        else if (strcmp(argv[i], "--dt") == 0 && i + 1 < argc) state.time = std::max(0.0001f, strtof(argv[++i], nullptr));
+        else if (strcmp(argv[i], "--gpu-raycast") == 0) state.gpuRaycast = true;
+        else if (strcmp(argv[i], "--single-window") == 0) singleWindow = true;
+        else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            const char* speed = argv[++i];
+            if (strcmp(speed, "max") == 0) {
+                state.speedMode = 2;
+            } else {
+                state.speedFactor = std::max(1.0f, strtof(speed, nullptr));
+                state.speedMode = 1;
+            }
+        }
+        else if (strcmp(argv[i], "--display-hz") == 0 && i + 1 < argc) state.displayHz = std::max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--no-vsync") == 0) state.vsync = false;
+        else if (strcmp(argv[i], "--offscreen") == 0 && i + 1 < argc) offscreen.dir = argv[++i];
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) offscreen.frames = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) offscreen.fps = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--raw") == 0) offscreen.raw = true;
+        else if (strcmp(argv[i], "--target") == 0 && i + 1 < argc) sscanf(argv[++i], "%f,%f", &offscreen.targetX, &offscreen.targetY);
+    }
+
+    Field field;
+    std::string fieldError;
+    if (fieldPath && !field.load(fieldPath, fieldError)) {
+        std::cerr << fieldError << ", using the plain walls" << std::endl;
+        fieldPath = nullptr;
+    }
+
+    if (offscreen.dir) {
+#ifdef PIDSIM_OFFSCREEN
+        return RunOffscreen(offscreen, state, fieldPath ? &field : nullptr);
+#else
+        std::cerr << "this pid_sim was built without EGL, so --offscreen is unavailable" << std::endl;
+        return 1;
+#endif
+    }
+
     if (!glfwInit()) return -1;
     
     glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
@@ -187,72 +717,230 @@ int main(void)
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "PID Tuning Sim (Map)", NULL, NULL);
-    GLFWwindow* window2 = glfwCreateWindow(WIDTH2, HEIGHT2, "Robot View", NULL, window);
+    // --single-window puts the map and Robot View side by side in one window
+    // with one swap per frame; otherwise each gets its own window.
+    GLFWwindow* window;
+    GLFWwindow* window2 = nullptr;
+    if (singleWindow) {
+        window = glfwCreateWindow(WIDTH + WIDTH2, std::max(HEIGHT, HEIGHT2), "PID Tuning Sim", NULL, NULL);
+    } else {
+        window = glfwCreateWindow(WIDTH, HEIGHT, "PID Tuning Sim (Map)", NULL, NULL);
+        window2 = window ? glfwCreateWindow(WIDTH2, HEIGHT2, "Robot View", NULL, window) : nullptr;
+    }
+    GLFWwindow* viewWindow = singleWindow ? window : window2;
     
-    if (!window || !window2) { glfwTerminate(); return -1; }
+    if (!window || !viewWindow) { glfwTerminate(); return -1; }
 
     glfwMakeContextCurrent(window);
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) return -1;
 
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
+#ifdef IMGUI_HAS_DOCK
+    // Only the combined window has room to dock the panel against.
+    if (singleWindow) ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+#endif
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
 
     glDisable(GL_DEPTH_TEST);
-    GLuint shaderProgram = CreateShaderProgram();
-    GLuint rayProgram = CreateRenderRayProgram();
+    std::unique_ptr<Shaders> shaders = std::make_unique<Shaders>();
+    if (!shaders->ok()) { glfwTerminate(); return -1; }
+    shaders->camera.bind();
 
-    CircleIndicator mouseIndicator(0.0f, 0.0f);
-    SwerveDrive robot(0.0f, 0.0f);
-    TuningState state;
-    // Initialize in main
+    CircleIndicator mouseIndicator(shaders->map, 0.0f, 0.0f);
+
+    // VAOs aren't shared between contexts, so the raycaster's has to be made
+    // with the Robot View current. It lives for the whole session.
+    glfwMakeContextCurrent(viewWindow);
+    std::unique_ptr<Raycaster> raycaster = std::make_unique<Raycaster>(750, shaders->raycast);
+    if (fieldPath) raycaster->setField(&field);
+
+    // Timer queries aren't shared between contexts either: one per window.
+    Profiler profiler;
+    std::unique_ptr<GpuTimer> viewGpu = std::make_unique<GpuTimer>(profiler, Profiler::GpuView);
+    glfwMakeContextCurrent(window);
+    std::unique_ptr<GpuTimer> mapGpu = std::make_unique<GpuTimer>(profiler, Profiler::GpuMap);
+    uint64_t profiledTick = 0;
+
+    SwerveDriveRenderer robotRenderer(shaders->map);
+
+    // Optional crowd of jittered-gain robots stepped here on the render
+    // thread, drawn with the instanced renderer instead of one call each.
+    std::unique_ptr<FleetSim> fleet;
+    std::unique_ptr<InstancedRenderer> instanced;
+    FixedStepClock fleetClock{state.time};
+    if (fleetSize > 0) {
+        fleet = std::make_unique<FleetSim>(fleetSize, state.moveGains, state.turnGains, 0.2f, 1u);
+        instanced = std::make_unique<InstancedRenderer>();
+    }
+    double lastFrame = glfwGetTime();
     
+    SimThread simThread(MakeSimInput(state, 0.0f, 0.0f));
+    if (recordPath && !simThread.record(recordPath)) {
+        std::cerr << "could not open " << recordPath << " for recording" << std::endl;
+    }
+    simThread.start();
 
-    PID pid_x(state.moveGains[0], state.moveGains[1], state.moveGains[2]);
-    PID pid_y(state.moveGains[0], state.moveGains[1], state.moveGains[2]);
-    PID pid_r(state.turnGains[0], state.turnGains[1], state.turnGains[2]);
-
-    while (!glfwWindowShouldClose(window) && !glfwWindowShouldClose(window2)) {
-        glfwPollEvents();
-
-        double mouseX, mouseY;
-        glfwGetCursorPos(window, &mouseX, &mouseY);
-        float ndcX = ((2.0f * (float)mouseX) / WIDTH - 1.0f) * aspect_ratio;
-        float ndcY = (1.0f - (2.0f * (float)mouseY) / HEIGHT);
-
-        mouseIndicator.x = ndcX;
-        mouseIndicator.y = ndcY;
-        
-        float dx = ndcX - robot.x;
-        float dy = ndcY - robot.y;
-        float targetAngle = atan2(dy, dx) - 1.5708f;
-        float dr = targetAngle - robot.r; 
-        while (dr >  M_PI) dr -= 2.0f * M_PI;
-        while (dr < -M_PI) dr += 2.0f * M_PI;
-
-        robot.updatePose(
-            pid_x.calculate_error(dx, state.time), 
-            pid_y.calculate_error(dy, state.time), 
-            pid_r.calculate_error(dr, state.time),
-            state.time
-        ); 
-
-        RenderUI(state, pid_x, pid_y, pid_r, robot);
-        RenderMapWindow(window, shaderProgram, robot, mouseIndicator);
+    bool vsyncApplied = !state.vsync;
+    double frameSlot = SimClockNow();
+    bool mouseWasDown = false;
+    double speedWall = frameSlot, speedSimTime = 0.0;
+
+    while (!glfwWindowShouldClose(window) && !glfwWindowShouldClose(viewWindow)) {
+        WaitForNextFrame(state.displayHz, frameSlot);
+        profiler.beginFrame();
+
+        if (state.vsync != vsyncApplied) {
+            ApplyVsync(window, viewWindow, state.vsync);
+            vsyncApplied = state.vsync;
+        }
+
+        float targetX, targetY;
+        {
+            ProfileScope scope(profiler, "input");
+            glfwPollEvents();
+
+            double mouseX, mouseY;
+            glfwGetCursorPos(window, &mouseX, &mouseY);
+            float ndcX = ((2.0f * (float)mouseX) / WIDTH - 1.0f) * aspect_ratio;
+            float ndcY = (1.0f - (2.0f * (float)mouseY) / HEIGHT);
+
+            // Only fresh presses on the map itself move a click target, not
+            // ones meant for the ImGui panel.
+            bool mouseDown = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+            bool onMap = mouseX >= 0.0 && mouseX < WIDTH && mouseY >= 0.0 && mouseY < HEIGHT;
+            if (mouseDown && !mouseWasDown && onMap && !ImGui::GetIO().WantCaptureMouse) {
+                state.clickX = ndcX;
+                state.clickY = ndcY;
+            }
+            mouseWasDown = mouseDown;
+
+            targetX = state.clickTarget ? state.clickX : ndcX;
+            targetY = state.clickTarget ? state.clickY : ndcY;
+            mouseIndicator.x = targetX;
+            mouseIndicator.y = targetY;
+
+            simThread.setInput(MakeSimInput(state, targetX, targetY));
+        }
+
+        // The sim runs ahead on its own thread; draw where it was between
+        // its last two ticks. Flat out there's no schedule to place it on,
+        // so just show the newest pose.
+        const SimSnapshot& snapshot = simThread.latest();
+        float alpha = 1.0f;
+        if (snapshot.speed > 0.0f) alpha = (float)((SimClockNow() - snapshot.tickTime) * snapshot.speed / snapshot.dt);
+        SwerveDrive robot = interpolatePose(snapshot.robot, std::min(std::max(alpha, 0.0f), 1.0f));
+
+        double speedNow = SimClockNow();
+        if (speedNow - speedWall >= 0.5) {
+            state.measuredSpeed = (float)((snapshot.simTime - speedSimTime) / (speedNow - speedWall));
+            speedWall = speedNow;
+            speedSimTime = snapshot.simTime;
+        }
+
+        // Only the newest batch is visible from here; older ones this frame
+        // were overwritten before we looked.
+        if (snapshot.tick != profiledTick) {
+            profiler.record(Profiler::Sim, "PID + updatePose", snapshot.batchStart, snapshot.batchSeconds);
+            profiledTick = snapshot.tick;
+        }
+
+        {
+            ProfileScope scope(profiler, "RenderUI");
+            RenderUI(state, snapshot, simThread.telemetry(), profiler);
+        }
+
+        // Shared by every map program through the Camera block.
+        glfwMakeContextCurrent(window);
+        shaders->camera.update(glm::mat4(1.0f), glm::ortho(-aspect_ratio, aspect_ratio, -1.0f, 1.0f, -1.0f, 1.0f));
+
+        if (fleet) {
+            ProfileScope scope(profiler, "fleet step");
+            double now = glfwGetTime();
+            fleetClock.step = state.time;
+            fleet->setGains(state.moveGains, state.turnGains);
+            // Flat out, the fleet takes its per-frame step cap every frame.
+            float speed = SimSpeed(state);
+            int steps = fleetClock.maxStepsPerFrame;
+            if (speed > 0.0f) steps = fleetClock.advance((now - lastFrame) * speed);
+            else fleetClock.accumulator = 0.0;
+            for (; steps > 0; steps--) {
+                fleet->step(targetX, targetY, state.time);
+            }
+            lastFrame = now;
+        }
+
+        if (singleWindow) {
+            // Map on the left, Robot View on the right, then ImGui over both.
+            int frameW, frameH;
+            glfwGetFramebufferSize(window, &frameW, &frameH);
+            Viewport mapPane{0, 0, frameW * (int)WIDTH / (int)(WIDTH + WIDTH2), frameH};
+            Viewport viewPane{mapPane.width, 0, frameW - mapPane.width, frameH};
+            {
+                ProfileScope scope(profiler, "map");
+                mapGpu->begin("map");
+                UsePane(mapPane);
+                DrawMapScene(*shaders, robotRenderer, instanced.get(), fleet.get(), robot, mouseIndicator);
+                mapGpu->end();
+            }
+            {
+                ProfileScope scope(profiler, "raycast build + draw");
+                viewGpu->begin("robot view");
+                UsePane(viewPane);
+                DrawRobotView(*raycaster, *shaders, state.gpuRaycast, robot, targetX, targetY, viewPane);
+                viewGpu->end();
+            }
+            {
+                ProfileScope scope(profiler, "ImGui draw");
+                glDisable(GL_SCISSOR_TEST);
+                glViewport(0, 0, frameW, frameH);
+                mapGpu->begin("ImGui");
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+                mapGpu->end();
+            }
+            {
+                ProfileScope scope(profiler, "swap");
+                glfwSwapBuffers(window);
+            }
+            continue;
+        }
+
+        // Two windows: map (with ImGui) first, then the Robot View.
+        {
+            ProfileScope scope(profiler, "RenderMapWindow");
+            RenderMapWindow(window, *mapGpu, *shaders, robotRenderer, instanced.get(), fleet.get(), robot, mouseIndicator);
+        }
+        {
+            ProfileScope scope(profiler, "swap (map)");
+            glfwSwapBuffers(window);
+        }
 
         glfwMakeContextCurrent(window2);
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        Raycaster raycaster(750);
-        
-        raycaster.updateAndDraw(rayProgram, robot.x, robot.y, robot.r);
-        raycaster.drawCursor(rayProgram, robot.x, robot.y, robot.r, ndcX, ndcY);
-        glfwSwapBuffers(window2);
+        {
+            ProfileScope scope(profiler, "raycast build + draw");
+            int viewW, viewH;
+            glfwGetFramebufferSize(window2, &viewW, &viewH);
+            viewGpu->begin("robot view");
+            DrawRobotView(*raycaster, *shaders, state.gpuRaycast, robot, targetX, targetY, Viewport{0, 0, viewW, viewH});
+            viewGpu->end();
+        }
+        {
+            ProfileScope scope(profiler, "swap (robot view)");
+            glfwSwapBuffers(window2);
+        }
     }
 
+    simThread.stop();
+
+    glfwMakeContextCurrent(viewWindow);
+    raycaster.reset();
+    viewGpu.reset();
+    glfwMakeContextCurrent(window);
+    mapGpu.reset();
+    instanced.reset();
+    shaders.reset();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -0,0 +1,156 @@
+#include "autotune.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "robot.hpp"
+#include "sim.hpp"
+
+RelayResult relayExperiment(RelayAxis axis, const RelayConfig& config) {
+    RelayResult result;
+    SwerveDrive robot(0.0f, 0.0f);
+    bool translation = axis == RelayAxis::Translation;
+
+    // Rotation sees its error the way Simulation::step forms it: aim at a
+    // point in the setpoint direction, atan2 and wrap. The robot doesn't
+    // translate here, so the coupling with the translation loop isn't
+    // modelled, and r is the same Verlet plant as x: expect the same Ku and
+    // Pu on both axes. The scenario check in autotune() covers the coupling.
+    float aimX = cosf(config.setpoint + 1.5708f);
+    float aimY = sinf(config.setpoint + 1.5708f);
+
+    // Commands wait here delaySteps() ticks before reaching the plant.
+    std::vector<float> pipeline(std::max(config.delaySteps(), 0) + 1, 0.0f);
+    size_t head = 0;
+
+    float h = config.relayAmplitude;
+    float u = h;
+    float prevError = config.setpoint;
+    std::vector<int> crossings;
+    int wanted = config.settleCycles + config.measureCycles + 1;
+    float lo = 0.0f, hi = 0.0f;
+
+    for (int n = 0; n < config.maxSteps; n++) {
+        float e = translation ? config.setpoint - robot.x
+                              : wrapAngle(atan2(aimY - robot.y, aimX - robot.x) - 1.5708f - robot.r);
+        if (e > config.hysteresis) u = h;
+        else if (e < -config.hysteresis) u = -h;
+
+        if (prevError <= 0.0f && e > 0.0f) {
+            crossings.push_back(n);
+            if ((int)crossings.size() == config.settleCycles + 1) lo = hi = e;
+            if ((int)crossings.size() == wanted) break;
+        }
+        if ((int)crossings.size() > config.settleCycles) {
+            lo = std::min(lo, e);
+            hi = std::max(hi, e);
+        }
+        prevError = e;
+
+        pipeline[head] = u;
+        head = (head + 1) % pipeline.size();
+        float applied = pipeline[head];
+
+        float a = translation ? applied : 0.0f;
+        float ar = translation ? 0.0f : applied;
+        robot.updatePose(a, 0.0f, ar, config.dt);
+    }
+
+    if ((int)crossings.size() < wanted) return result;
+
+    result.amplitude = 0.5f * (hi - lo);
+    float eps = config.hysteresis;
+    if (result.amplitude <= eps) return result;
+
+    int first = crossings[config.settleCycles];
+    result.ultimatePeriod = (crossings.back() - first) * config.dt / config.measureCycles;
+    result.ultimateGain = 4.0f * h / ((float)M_PI * std::sqrt(result.amplitude * result.amplitude - eps * eps));
+    result.ok = true;
+    return result;
+}
+
+// Both rules give Kp, Ti, Td; PID wants the parallel form P, I = Kp/Ti, D = Kp*Td.
+void zieglerNicholsGains(float ku, float pu, float out[3]) {
+    float kp = 0.6f * ku;
+    out[0] = kp;
+    out[1] = kp / (0.5f * pu);
+    out[2] = kp * (pu / 8.0f);
+}
+
+void tyreusLuybenGains(float ku, float pu, float out[3]) {
+    float kp = ku / 2.2f;
+    out[0] = kp;
+    out[1] = kp / (2.2f * pu);
+    out[2] = kp * (pu / 6.3f);
+}
+
+namespace {
+
+void Check(TuningSuggestion& s, const Scenario& scenario, float maxOvershoot) {
+    Gains gains;
+    std::copy(s.move, s.move + 3, gains.move);
+    std::copy(s.turn, s.turn + 3, gains.turn);
+    s.check = evaluateGains(gains, scenario);
+
+    const RunResult& r = s.check;
+    s.usable = false;
+    if (r.diverged) s.problem = "diverges";
+    else if (r.saturated) s.problem = "saturates";
+    else if (r.translation.settlingTime < 0.0f || r.rotation.settlingTime < 0.0f) s.problem = "never settles";
+    else if (std::max(r.translation.overshoot, r.rotation.overshoot) > maxOvershoot) s.problem = "overshoots too far";
+    else {
+        s.usable = true;
+        s.problem = "";
+    }
+}
+
+bool FitsLimits(const float gains[3], const float limits[3]) {
+    return gains[0] <= limits[0] && gains[1] <= limits[1] && gains[2] <= limits[2];
+}
+
+// The rule's Kp and D with I dropped (see autotune.hpp), then Kp backed off
+// until the scenario check passes. Lowering Kp under a fixed D only adds
+// damping, so the first usable step is the fastest one on offer.
+void Suggest(TuningSuggestion& s, void (*rule)(float, float, float[3]), const RelayResult& t, const RelayResult& r,
+             const RelayConfig& config, const Scenario& scenario) {
+    float move[3], turn[3];
+    rule(t.ultimateGain, t.ultimatePeriod, move);
+    rule(r.ultimateGain, r.ultimatePeriod, turn);
+
+    s.kpScale = 1.0f;
+    for (int attempt = 0;; attempt++) {
+        s.move[0] = move[0] * s.kpScale;
+        s.turn[0] = turn[0] * s.kpScale;
+        s.move[1] = s.turn[1] = 0.0f;
+        s.move[2] = move[2];
+        s.turn[2] = turn[2];
+        if (s.move[2] > config.maxGain[2] || s.turn[2] > config.maxGain[2]) {
+            s.problem = "needs more D than the gain limits allow";
+            return;
+        }
+        if (FitsLimits(s.move, config.maxGain) && FitsLimits(s.turn, config.maxGain)) {
+            Check(s, scenario, config.maxOvershoot);
+            if (s.usable) return;
+        } else {
+            s.problem = "exceeds the gain limits";
+        }
+        // Out of attempts: the last one's gains and problem are the report.
+        if (attempt >= config.maxBackoffs) return;
+        s.kpScale *= config.backoff;
+    }
+}
+
+}
+
+AutotuneResult autotune(const RelayConfig& config, const Scenario& scenario) {
+    AutotuneResult result;
+    result.translation = relayExperiment(RelayAxis::Translation, config);
+    result.rotation = relayExperiment(RelayAxis::Rotation, config);
+    if (!result.translation.ok || !result.rotation.ok) return result;
+
+    Scenario checked = scenario;
+    checked.latency = config.latency;
+    Suggest(result.zieglerNichols, zieglerNicholsGains, result.translation, result.rotation, config, checked);
+    Suggest(result.tyreusLuyben, tyreusLuybenGains, result.translation, result.rotation, config, checked);
+    return result;
+}
@@ -0,0 +1,226 @@
+#include "field.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+inline float Cross(float ax, float ay, float bx, float by) {
+    return ax * by - ay * bx;
+}
+
+// Distance along the ray to the segment, or inf if it misses.
+inline float HitSegment(const Segment& s, float ox, float oy, float dx, float dy) {
+    float ex = s.x1 - s.x0, ey = s.y1 - s.y0;
+    float denom = Cross(dx, dy, ex, ey);
+    if (std::fabs(denom) < 1e-12f) return INFINITY;
+
+    float wx = s.x0 - ox, wy = s.y0 - oy;
+    float t = Cross(wx, wy, ex, ey) / denom;
+    float u = Cross(wx, wy, dx, dy) / denom;
+    return (t >= 0.0f && u >= 0.0f && u <= 1.0f) ? t : INFINITY;
+}
+
+}
+
+Field Field::box(float limitX, float limitY) {
+    Field f;
+    f.addSegment(-limitX, -limitY, -limitX, limitY, 0.7f, 0.3f, 0.3f);
+    f.addSegment(limitX, -limitY, limitX, limitY, 0.7f, 0.3f, 0.3f);
+    f.addSegment(-limitX, -limitY, limitX, -limitY, 0.3f, 0.4f, 0.6f);
+    f.addSegment(-limitX, limitY, limitX, limitY, 0.3f, 0.4f, 0.6f);
+    f.build();
+    return f;
+}
+
+void Field::addSegment(float x0, float y0, float x1, float y1, float r, float g, float b) {
+    segments.push_back({x0, y0, x1, y1, r, g, b});
+}
+
+void Field::addPolygon(const std::vector<float>& xy, float r, float g, float b) {
+    size_t points = xy.size() / 2;
+    for (size_t i = 0; i < points; i++) {
+        size_t j = (i + 1) % points;
+        addSegment(xy[2 * i], xy[2 * i + 1], xy[2 * j], xy[2 * j + 1], r, g, b);
+    }
+}
+
+bool Field::load(const std::string& path, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "could not open " + path;
+        return false;
+    }
+
+    Field loaded;
+    float r = 0.8f, g = 0.8f, b = 0.8f;
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(file, line)) {
+        lineNo++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream in(line);
+        std::string kind;
+        if (!(in >> kind)) continue;
+
+        std::vector<float> values;
+        float v;
+        while (in >> v) values.push_back(v);
+        bool ok = in.eof();
+
+        if (kind == "color" && ok && values.size() == 3) {
+            r = values[0];
+            g = values[1];
+            b = values[2];
+        } else if (kind == "segment" && ok && values.size() == 4) {
+            loaded.addSegment(values[0], values[1], values[2], values[3], r, g, b);
+        } else if (kind == "polygon" && ok && values.size() >= 6 && values.size() % 2 == 0) {
+            loaded.addPolygon(values, r, g, b);
+        } else {
+            error = path + ":" + std::to_string(lineNo) + ": can't parse '" + line + "'";
+            return false;
+        }
+    }
+
+    if (loaded.segments.empty()) {
+        error = path + ": no geometry";
+        return false;
+    }
+
+    segments = std::move(loaded.segments);
+    build();
+    return true;
+}
+
+// Visits the cells along the ray in order until tMax or until visit(cell,
+// tExit) returns true. tExit is where the ray leaves that cell.
+template <typename Visit>
+void Field::traverse(float ox, float oy, float dx, float dy, float tMax, Visit visit) const {
+    if (nx == 0) return;
+    float maxX = minX + nx * cellSize, maxY = minY + ny * cellSize;
+
+    // Clip the ray to the grid first, in case it starts outside.
+    float tEnter = 0.0f, tLeave = tMax;
+    float lo[2] = {minX, minY}, hi[2] = {maxX, maxY}, o[2] = {ox, oy}, d[2] = {dx, dy};
+    for (int a = 0; a < 2; a++) {
+        if (d[a] == 0.0f) {
+            if (o[a] < lo[a] || o[a] > hi[a]) return;
+            continue;
+        }
+        float t0 = (lo[a] - o[a]) / d[a], t1 = (hi[a] - o[a]) / d[a];
+        if (t0 > t1) std::swap(t0, t1);
+        tEnter = std::max(tEnter, t0);
+        tLeave = std::min(tLeave, t1);
+    }
+    if (tEnter > tLeave) return;
+
+    float px = ox + dx * tEnter, py = oy + dy * tEnter;
+    int cx = std::min(std::max((int)((px - minX) / cellSize), 0), nx - 1);
+    int cy = std::min(std::max((int)((py - minY) / cellSize), 0), ny - 1);
+
+    int stepX = (dx > 0.0f) ? 1 : -1, stepY = (dy > 0.0f) ? 1 : -1;
+    float nextX = minX + (cx + (stepX > 0 ? 1 : 0)) * cellSize;
+    float nextY = minY + (cy + (stepY > 0 ? 1 : 0)) * cellSize;
+    float tMaxX = (dx != 0.0f) ? (nextX - ox) / dx : INFINITY;
+    float tMaxY = (dy != 0.0f) ? (nextY - oy) / dy : INFINITY;
+    float tDeltaX = (dx != 0.0f) ? cellSize / std::fabs(dx) : INFINITY;
+    float tDeltaY = (dy != 0.0f) ? cellSize / std::fabs(dy) : INFINITY;
+
+    for (;;) {
+        float tExit = std::min(std::min(tMaxX, tMaxY), tLeave);
+        if (visit(cy * nx + cx, tExit) || tExit >= tLeave) return;
+
+        if (tMaxX < tMaxY) {
+            cx += stepX;
+            tMaxX += tDeltaX;
+            if (cx < 0 || cx >= nx) return;
+        } else {
+            cy += stepY;
+            tMaxY += tDeltaY;
+            if (cy < 0 || cy >= ny) return;
+        }
+    }
+}
+
+void Field::build() {
+    cellStart.clear();
+    cellItems.clear();
+    nx = ny = 0;
+    if (segments.empty()) return;
+
+    float maxX = -INFINITY, maxY = -INFINITY;
+    minX = minY = INFINITY;
+    for (const Segment& s : segments) {
+        minX = std::min(minX, std::min(s.x0, s.x1));
+        minY = std::min(minY, std::min(s.y0, s.y1));
+        maxX = std::max(maxX, std::max(s.x0, s.x1));
+        maxY = std::max(maxY, std::max(s.y0, s.y1));
+    }
+
+    // About two cells per segment along each axis keeps cell lists short
+    // without making empty space expensive to walk.
+    int cells = std::min(std::max((int)std::ceil(std::sqrt((float)segments.size()) * 2.0f), 4), 512);
+    float extent = std::max(maxX - minX, maxY - minY);
+    cellSize = extent / cells;
+    if (cellSize <= 0.0f) cellSize = 1.0f;
+    // Pad a cell on every side so geometry on the bounding box sits inside.
+    minX -= cellSize;
+    minY -= cellSize;
+    nx = (int)std::ceil((maxX - minX) / cellSize) + 1;
+    ny = (int)std::ceil((maxY - minY) / cellSize) + 1;
+
+    // Rasterize each segment by walking it through the grid like a ray.
+    std::vector<std::vector<uint32_t>> perCell(nx * ny);
+    for (uint32_t i = 0; i < segments.size(); i++) {
+        const Segment& s = segments[i];
+        float ex = s.x1 - s.x0, ey = s.y1 - s.y0;
+        float len = std::sqrt(ex * ex + ey * ey);
+        if (len == 0.0f) continue;
+        traverse(s.x0, s.y0, ex / len, ey / len, len, [&](int cell, float) {
+            perCell[cell].push_back(i);
+            return false;
+        });
+    }
+
+    cellStart.resize(nx * ny + 1);
+    cellStart[0] = 0;
+    for (int c = 0; c < nx * ny; c++) cellStart[c + 1] = cellStart[c] + (uint32_t)perCell[c].size();
+    cellItems.reserve(cellStart.back());
+    for (const auto& items : perCell) cellItems.insert(cellItems.end(), items.begin(), items.end());
+}
+
+FieldHit Field::raycast(float ox, float oy, float dx, float dy) const {
+    FieldHit best{INFINITY, -1};
+    traverse(ox, oy, dx, dy, INFINITY, [&](int cell, float tExit) {
+        for (uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+            uint32_t i = cellItems[k];
+            float t = HitSegment(segments[i], ox, oy, dx, dy);
+            if (t < best.t) best = {t, (int)i};
+        }
+        // A hit past this cell could still be beaten by something in a
+        // later cell, so only stop once it's inside the cells walked so far.
+        return best.t <= tExit;
+    });
+    return best;
+}
+
+FieldHit Field::raycastBruteForce(float ox, float oy, float dx, float dy) const {
+    FieldHit best{INFINITY, -1};
+    for (size_t i = 0; i < segments.size(); i++) {
+        float t = HitSegment(segments[i], ox, oy, dx, dy);
+        if (t < best.t) best = {t, (int)i};
+    }
+    return best;
+}
+
+void castRays(const RayScan& scan, const Field& field, int count, float* depth, int32_t* hitSegment) {
+    float center = scanCenter(scan);
+    for (int i = 0; i < count; i++) {
+        float rayAngle = (center - scan.fovRad / 2.0f) + ((float)i / (float)count) * scan.fovRad;
+        FieldHit hit = field.raycast(scan.x, scan.y, std::cos(rayAngle), std::sin(rayAngle));
+        depth[i] = scan.perpendicular ? hit.t * std::cos(rayAngle - center) : hit.t;
+        if (hitSegment) hitSegment[i] = hit.segment;
+    }
+}
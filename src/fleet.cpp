@@ -0,0 +1,70 @@
+#include "fleet.hpp"
+#include "simd.hpp"
+
+namespace {
+
+// The operation order matches SwerveDrive::updatePose exactly so every path
+// rounds the same way: p + (p - back) * friction + (a * dt) * dt. Plain
+// enough that -O3 vectorizes it at whatever width the caller is built for.
+PIDSIM_ALWAYS_INLINE void VerletLoop(float* __restrict p, float* __restrict back, const float* __restrict a, size_t n, float dt) {
+    const float friction = SwerveDrive::friction;
+    for (size_t i = 0; i < n; i++) {
+        float store = p[i];
+        p[i] = p[i] + (p[i] - back[i]) * friction + a[i] * dt * dt;
+        back[i] = store;
+    }
+}
+
+void Verlet(float* p, float* back, const float* a, size_t n, float dt) {
+    VerletLoop(p, back, a, n, dt);
+}
+
+#if PIDSIM_X86_DISPATCH && !defined(__AVX2__)
+PIDSIM_TARGET_AVX2 void VerletAvx2(float* p, float* back, const float* a, size_t n, float dt) {
+    VerletLoop(p, back, a, n, dt);
+}
+#endif
+
+// Same loop, kept one lane wide as the reference.
+PIDSIM_SCALAR_REFERENCE void VerletScalar(float* p, float* back, const float* a, size_t n, float dt) {
+    const float friction = SwerveDrive::friction;
+    PIDSIM_NO_VECTORIZE_LOOP
+    for (size_t i = 0; i < n; i++) {
+        float store = p[i];
+        p[i] = p[i] + (p[i] - back[i]) * friction + a[i] * dt * dt;
+        back[i] = store;
+    }
+}
+
+}
+
+void Fleet::updatePose(const float* x_a, const float* y_a, const float* r_a, float dt) {
+    size_t n = size();
+    auto verlet = Verlet;
+#if PIDSIM_X86_DISPATCH && !defined(__AVX2__)
+    if (cpuHasAvx2()) verlet = VerletAvx2;
+#endif
+    verlet(x.data(), x_back.data(), x_a, n, dt);
+    verlet(y.data(), y_back.data(), y_a, n, dt);
+    verlet(r.data(), r_back.data(), r_a, n, dt);
+}
+
+void Fleet::updatePoseScalar(const float* x_a, const float* y_a, const float* r_a, float dt) {
+    size_t n = size();
+    VerletScalar(x.data(), x_back.data(), x_a, n, dt);
+    VerletScalar(y.data(), y_back.data(), y_a, n, dt);
+    VerletScalar(r.data(), r_back.data(), r_a, n, dt);
+}
+
+const char* Fleet::simdPath() {
+#if defined(__AVX2__)
+    return "avx2";
+#else
+    if (cpuHasAvx2()) return "avx2";
+#if defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+#endif
+}
@@ -0,0 +1,47 @@
+#include "fleet_sim.hpp"
+
+#include <cmath>
+#include <random>
+#include "sim.hpp"
+
+FleetSim::FleetSim(size_t count, const float moveGains[3], const float turnGains[3], float gainJitter, unsigned seed)
+    : moveScale(count), turnScale(count), ax(count), ay(count), ar(count) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> pos(-0.9f, 0.9f);
+    std::uniform_real_distribution<float> jitter(1.0f - gainJitter, 1.0f + gainJitter);
+
+    for (size_t i = 0; i < count; i++) {
+        fleet.add(pos(rng), pos(rng));
+        moveScale[i] = jitter(rng);
+        turnScale[i] = jitter(rng);
+        pid_x.add(0.0f, 0.0f, 0.0f);
+        pid_y.add(0.0f, 0.0f, 0.0f);
+        pid_r.add(0.0f, 0.0f, 0.0f);
+    }
+    setGains(moveGains, turnGains);
+}
+
+void FleetSim::setGains(const float moveGains[3], const float turnGains[3]) {
+    for (size_t i = 0; i < size(); i++) {
+        pid_x.P[i] = pid_y.P[i] = moveGains[0] * moveScale[i];
+        pid_x.I[i] = pid_y.I[i] = moveGains[1] * moveScale[i];
+        pid_x.D[i] = pid_y.D[i] = moveGains[2] * moveScale[i];
+        pid_r.P[i] = turnGains[0] * turnScale[i];
+        pid_r.I[i] = turnGains[1] * turnScale[i];
+        pid_r.D[i] = turnGains[2] * turnScale[i];
+    }
+}
+
+void FleetSim::step(float targetX, float targetY, float dt) {
+    for (size_t i = 0; i < size(); i++) {
+        float dx = targetX - fleet.x[i];
+        float dy = targetY - fleet.y[i];
+        ax[i] = dx;
+        ay[i] = dy;
+        ar[i] = wrapAngle(atan2(dy, dx) - 1.5708f - fleet.r[i]);
+    }
+    pid_x.step(ax.data(), dt, ax.data());
+    pid_y.step(ay.data(), dt, ay.data());
+    pid_r.step(ar.data(), dt, ar.data());
+    fleet.updatePose(ax.data(), ay.data(), ar.data(), dt);
+}
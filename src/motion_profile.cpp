@@ -0,0 +1,106 @@
+#include "motion_profile.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void MotionProfile::build(float distance, const ProfileLimits& limits, float dt) {
+    step = dt;
+    samples.clear();
+
+    float d = std::max(distance, 0.0f);
+    float vMax = std::max(limits.maxVel, 1e-6f);
+    float aMax = std::max(limits.maxAccel, 1e-6f);
+
+    // Trapezoid, or a triangle when there's no room to reach vMax.
+    float ta = vMax / aMax;
+    float tc;
+    if (aMax * ta * ta > d) {
+        ta = std::sqrt(d / aMax);
+        vMax = aMax * ta;
+        tc = 0.0f;
+    } else {
+        tc = (d - aMax * ta * ta) / vMax;
+    }
+    float total = 2.0f * ta + tc;
+
+    size_t n = (size_t)std::ceil(total / dt) + 1;
+    raw.resize(n);
+    for (size_t k = 0; k < n; k++) {
+        float t = k * dt;
+        ProfileSample& s = raw[k];
+        if (t >= total) {
+            s = {d, 0.0f, 0.0f};
+        } else if (t < ta) {
+            s = {0.5f * aMax * t * t, aMax * t, aMax};
+        } else if (t < ta + tc) {
+            s = {0.5f * aMax * ta * ta + vMax * (t - ta), vMax, 0.0f};
+        } else {
+            float left = total - t;
+            s = {d - 0.5f * aMax * left * left, aMax * left, -aMax};
+        }
+    }
+
+    // Averaging turns each step in acceleration into a ramp of step / window.
+    // Steps are aMax apart when the cruise is at least a window long;
+    // otherwise the two in the middle can land in one window, so it doubles.
+    size_t window = 1;
+    if (limits.maxJerk > 0.0f) {
+        float width = aMax / limits.maxJerk;
+        if (tc < width) width *= 2.0f;
+        window = std::max<size_t>(1, (size_t)std::ceil(width / dt - 1e-3f));
+    }
+    if (window == 1) {
+        samples.swap(raw);
+        return;
+    }
+
+    // Moving average over the last `window` samples, with rest before the
+    // start and the end pose after it. Sums in double so long moves don't
+    // drift.
+    samples.resize(n + window - 1);
+    double pos = 0.0, vel = 0.0, acc = 0.0;
+    for (size_t k = 0; k < samples.size(); k++) {
+        const ProfileSample& in = raw[std::min(k, n - 1)];
+        pos += in.pos;
+        vel += in.vel;
+        acc += in.acc;
+        if (k >= window) {
+            const ProfileSample& out = raw[std::min(k - window, n - 1)];
+            pos -= out.pos;
+            vel -= out.vel;
+            acc -= out.acc;
+        }
+        samples[k] = {(float)(pos / window), (float)(vel / window), (float)(acc / window)};
+    }
+    samples.back() = {d, 0.0f, 0.0f};
+}
+
+Reference ProfileFollower::next(float targetX, float targetY, const SwerveDrive& robot, float dt) {
+    if (!started || targetX != goalX || targetY != goalY || dt != builtDt) {
+        started = true;
+        goalX = targetX;
+        goalY = targetY;
+        startX = robot.x;
+        startY = robot.y;
+        builtDt = dt;
+        tick = 0;
+
+        float dx = goalX - startX, dy = goalY - startY;
+        float length = std::sqrt(dx * dx + dy * dy);
+        dirX = length > 0.0f ? dx / length : 0.0f;
+        dirY = length > 0.0f ? dy / length : 0.0f;
+        motion.build(length, limits, dt);
+    }
+
+    ProfileSample s = motion.sample(tick++ * dt);
+    float ff = s.acc + (1.0f - SwerveDrive::friction) * s.vel / dt;
+
+    Reference ref;
+    ref.x = startX + dirX * s.pos;
+    ref.y = startY + dirY * s.pos;
+    ref.vx = dirX * s.vel;
+    ref.vy = dirY * s.vel;
+    ref.ffX = dirX * ff;
+    ref.ffY = dirY * ff;
+    return ref;
+}
@@ -0,0 +1,172 @@
+#include "offscreen.hpp"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+OffscreenContext::OffscreenContext() {
+    // Surfaceless needs the platform extension; fall back to the default
+    // display, which Mesa also serves without a window system.
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLDisplay dpy = getPlatformDisplay
+        ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr)
+        : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, nullptr, nullptr)) {
+        message = "no EGL display";
+        return;
+    }
+    display = dpy;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        message = "EGL has no desktop OpenGL";
+        return;
+    }
+
+    // Same 3.3 core profile the GLFW windows ask for.
+    const EGLint attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext ctx = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attribs);
+    if (ctx == EGL_NO_CONTEXT) {
+        message = "could not create a GL 3.3 core context";
+        return;
+    }
+
+    if (!eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx) ||
+        !gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        eglDestroyContext(dpy, ctx);
+        message = "could not make the GL context current";
+        return;
+    }
+    context = ctx;
+}
+
+OffscreenContext::~OffscreenContext() {
+    if (!display) return;
+    if (context) {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+    }
+    eglTerminate(display);
+}
+
+FrameTarget::FrameTarget(int w, int h) : width(w), height(h) {
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &color);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB8, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+FrameTarget::~FrameTarget() {
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &color);
+}
+
+void FrameTarget::bind() {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+}
+
+void FrameTarget::read(std::vector<unsigned char>& rgb) {
+    rgb.resize((size_t)width * height * 3);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rgb.data());
+}
+
+FrameWriter::FrameWriter(Format f, size_t maxFrames) : format(f), maxQueued(maxFrames) {
+    thread = std::thread([this] { run(); });
+}
+
+FrameWriter::~FrameWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+    ready.notify_one();
+    thread.join();
+
+    for (auto& s : streams) fclose(s.second);
+}
+
+std::vector<unsigned char> FrameWriter::buffer() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (spare.empty()) return {};
+    std::vector<unsigned char> b = std::move(spare.back());
+    spare.pop_back();
+    return b;
+}
+
+void FrameWriter::write(const std::string& path, int width, int height, std::vector<unsigned char>&& rgb) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        drained.wait(lock, [this] { return queue.size() < maxQueued; });
+        queue.push_back({path, width, height, std::move(rgb)});
+    }
+    ready.notify_one();
+}
+
+void FrameWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    drained.wait(lock, [this] { return queue.empty(); });
+}
+
+int FrameWriter::failures() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return failed;
+}
+
+void FrameWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        ready.wait(lock, [this] { return done || !queue.empty(); });
+        if (queue.empty()) return;
+
+        // Leave the frame at the front until it's saved, so flush() waits for
+        // the disk and not just the hand-off.
+        Frame& frame = queue.front();
+        lock.unlock();
+        bool ok = save(frame);
+        lock.lock();
+
+        if (!ok) failed++;
+        spare.push_back(std::move(frame.rgb));
+        queue.pop_front();
+        drained.notify_all();
+    }
+}
+
+bool FrameWriter::save(const Frame& frame) {
+    FILE* f;
+    if (format == PPM) {
+        f = fopen(frame.path.c_str(), "wb");
+        if (!f) return false;
+        fprintf(f, "P6\n%d %d\n255\n", frame.width, frame.height);
+    } else {
+        // Only this thread touches streams.
+        auto it = streams.find(frame.path);
+        if (it == streams.end()) {
+            f = fopen(frame.path.c_str(), "wb");
+            if (!f) return false;
+            streams[frame.path] = f;
+        } else {
+            f = it->second;
+        }
+    }
+
+    // GL rows are bottom-up, images are top-down.
+    size_t row = (size_t)frame.width * 3;
+    bool ok = true;
+    for (int y = frame.height - 1; y >= 0 && ok; y--) {
+        ok = fwrite(&frame.rgb[y * row], 1, row, f) == row;
+    }
+
+    if (format == PPM) ok = (fclose(f) == 0) && ok;
+    return ok;
+}
@@ -0,0 +1,229 @@
+#include "optimize.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int N = 6;
+using Vec = std::array<double, N>;
+using Mat = std::array<std::array<double, N>, N>;
+
+void ToArray(const Gains& g, Vec& out) {
+    for (int i = 0; i < 3; i++) {
+        out[i] = g.move[i];
+        out[i + 3] = g.turn[i];
+    }
+}
+
+Gains FromArray(const Vec& v) {
+    Gains g;
+    for (int i = 0; i < 3; i++) {
+        g.move[i] = (float)v[i];
+        g.turn[i] = (float)v[i + 3];
+    }
+    return g;
+}
+
+// Cyclic Jacobi eigendecomposition of a symmetric matrix: a = V diag(d) V^T.
+// 6x6 is small enough that this converges in a handful of sweeps.
+void Eigen(Mat a, Mat& v, Vec& d) {
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < N; j++) v[i][j] = (i == j) ? 1.0 : 0.0;
+
+    for (int sweep = 0; sweep < 50; sweep++) {
+        double off = 0.0;
+        for (int p = 0; p < N; p++)
+            for (int q = p + 1; q < N; q++) off += a[p][q] * a[p][q];
+        if (off < 1e-30) break;
+
+        for (int p = 0; p < N; p++) {
+            for (int q = p + 1; q < N; q++) {
+                if (std::fabs(a[p][q]) < 1e-300) continue;
+                double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                double c = 1.0 / std::sqrt(t * t + 1.0);
+                double s = t * c;
+
+                for (int k = 0; k < N; k++) {
+                    double akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < N; k++) {
+                    double apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < N; k++) {
+                    double vkp = v[k][p], vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < N; i++) d[i] = a[i][i];
+}
+
+}
+
+OptimizerResult optimizeGains(const Scenario& scenario, const OptimizerConfig& config, ThreadPool& pool,
+                              const OptimizerProgress& progress) {
+    // Search in [0, 1]^6, scaled onto [lower, upper], so every gain moves on
+    // the same footing no matter its units.
+    Vec lo, hi, mean;
+    ToArray(config.lower, lo);
+    ToArray(config.upper, hi);
+    ToArray(config.start, mean);
+    for (int i = 0; i < N; i++) {
+        double span = std::max(hi[i] - lo[i], 1e-12);
+        mean[i] = std::min(std::max((mean[i] - lo[i]) / span, 0.0), 1.0);
+    }
+
+    // Standard CMA-ES constants (Hansen, "The CMA Evolution Strategy: A Tutorial").
+    int lambda = config.populationSize > 0 ? config.populationSize : 4 + (int)(3.0 * std::log((double)N));
+    int mu = lambda / 2;
+    std::vector<double> weights(mu);
+    for (int i = 0; i < mu; i++) weights[i] = std::log(mu + 0.5) - std::log(i + 1.0);
+    double wsum = std::accumulate(weights.begin(), weights.end(), 0.0);
+    double w2sum = 0.0;
+    for (double& w : weights) {
+        w /= wsum;
+        w2sum += w * w;
+    }
+    double mueff = 1.0 / w2sum;
+
+    double cc = (4.0 + mueff / N) / (N + 4.0 + 2.0 * mueff / N);
+    double cs = (mueff + 2.0) / (N + mueff + 5.0);
+    double c1 = 2.0 / ((N + 1.3) * (N + 1.3) + mueff);
+    double cmu = std::min(1.0 - c1, 2.0 * (mueff - 2.0 + 1.0 / mueff) / ((N + 2.0) * (N + 2.0) + mueff));
+    double damps = 1.0 + 2.0 * std::max(0.0, std::sqrt((mueff - 1.0) / (N + 1.0)) - 1.0) + cs;
+    double chiN = std::sqrt((double)N) * (1.0 - 1.0 / (4.0 * N) + 1.0 / (21.0 * N * N));
+
+    double sigma = config.initialSigma;
+    Vec pc{}, ps{}, diag;
+    Mat C{}, B{};
+    for (int i = 0; i < N; i++) {
+        C[i][i] = B[i][i] = 1.0;
+        diag[i] = 1.0;
+    }
+
+    std::mt19937 rng(config.seed);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    std::vector<Vec> xs(lambda), ys(lambda);
+    std::vector<Gains> candidates(lambda);
+    std::vector<float> costs(lambda);
+    std::vector<RunResult> runs(lambda);
+    std::vector<int> order(lambda);
+
+    OptimizerResult result;
+    result.bestCost = INFINITY;
+
+    while (result.evaluations + lambda <= std::max(config.maxEvaluations, lambda)) {
+        // Sample y = B D z, x = mean + sigma y.
+        for (int k = 0; k < lambda; k++) {
+            Vec z;
+            for (int i = 0; i < N; i++) z[i] = normal(rng) * diag[i];
+            for (int i = 0; i < N; i++) {
+                double y = 0.0;
+                for (int j = 0; j < N; j++) y += B[i][j] * z[j];
+                ys[k][i] = y;
+                xs[k][i] = mean[i] + sigma * y;
+            }
+
+            Vec gains;
+            for (int i = 0; i < N; i++) {
+                double clamped = std::min(std::max(xs[k][i], 0.0), 1.0);
+                gains[i] = lo[i] + (hi[i] - lo[i]) * clamped;
+            }
+            candidates[k] = FromArray(gains);
+        }
+
+        pool.parallelFor(lambda, [&](size_t k) {
+            runs[k] = evaluateGains(candidates[k], scenario);
+        });
+
+        for (int k = 0; k < lambda; k++) {
+            // Out-of-bounds samples were run clamped; a penalty on how far out
+            // they were keeps the mean from drifting off the box.
+            double outside = 0.0;
+            for (int i = 0; i < N; i++) {
+                double d = xs[k][i] - std::min(std::max(xs[k][i], 0.0), 1.0);
+                outside += d * d;
+            }
+            float cost = runCost(runs[k]);
+            costs[k] = std::isfinite(cost) ? cost + (float)outside : 1e30f;
+
+            if (runs[k].diverged) result.diverged++;
+            if (!runs[k].diverged && cost < result.bestCost) {
+                result.bestCost = cost;
+                result.best = runs[k];
+            }
+        }
+        result.evaluations += lambda;
+        result.generations++;
+
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return costs[a] < costs[b]; });
+
+        // Recombine the best mu samples.
+        Vec oldMean = mean, yw{};
+        for (int i = 0; i < N; i++) {
+            double m = 0.0;
+            for (int k = 0; k < mu; k++) m += weights[k] * xs[order[k]][i];
+            mean[i] = m;
+            yw[i] = (mean[i] - oldMean[i]) / sigma;
+        }
+
+        // C^{-1/2} yw = B D^-1 B^T yw
+        Vec bty{}, invsqrt{};
+        for (int j = 0; j < N; j++)
+            for (int i = 0; i < N; i++) bty[j] += B[i][j] * yw[i];
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j < N; j++) invsqrt[i] += B[i][j] * bty[j] / diag[j];
+
+        double csn = std::sqrt(cs * (2.0 - cs) * mueff);
+        double psNorm = 0.0;
+        for (int i = 0; i < N; i++) {
+            ps[i] = (1.0 - cs) * ps[i] + csn * invsqrt[i];
+            psNorm += ps[i] * ps[i];
+        }
+        psNorm = std::sqrt(psNorm);
+
+        double hsigBound = (1.4 + 2.0 / (N + 1.0)) * chiN *
+                           std::sqrt(1.0 - std::pow(1.0 - cs, 2.0 * result.generations));
+        double hsig = psNorm < hsigBound ? 1.0 : 0.0;
+
+        double ccn = std::sqrt(cc * (2.0 - cc) * mueff);
+        for (int i = 0; i < N; i++) pc[i] = (1.0 - cc) * pc[i] + hsig * ccn * yw[i];
+
+        for (int i = 0; i < N; i++) {
+            for (int j = 0; j <= i; j++) {
+                double rankMu = 0.0;
+                for (int k = 0; k < mu; k++) rankMu += weights[k] * ys[order[k]][i] * ys[order[k]][j];
+                double c = (1.0 - c1 - cmu) * C[i][j] +
+                           c1 * (pc[i] * pc[j] + (1.0 - hsig) * cc * (2.0 - cc) * C[i][j]) +
+                           cmu * rankMu;
+                C[i][j] = C[j][i] = c;
+            }
+        }
+
+        sigma *= std::exp((cs / damps) * (psNorm / chiN - 1.0));
+
+        Eigen(C, B, diag);
+        for (int i = 0; i < N; i++) diag[i] = std::sqrt(std::max(diag[i], 1e-20));
+
+        if (progress) progress(result.generations, result.evaluations, result.bestCost);
+
+        // Converged: the whole population fits inside a tiny box.
+        if (sigma * *std::max_element(diag.begin(), diag.end()) < 1e-6) break;
+    }
+
+    return result;
+}
@@ -0,0 +1,114 @@
+#include "pid_bank.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Everything step() touches, as raw pointers so the loops see no vectors.
+struct Streams {
+    const float *p, *i, *d, *lo, *hi;
+    float *accum, *back;
+};
+
+// The operation order matches PID::calculate_error (with the divide turned
+// into a multiply) so every path rounds the same way.
+PIDSIM_SCALAR_REFERENCE void StepRange(const Streams& s, const float* errors, float* out, size_t begin, size_t end,
+                                       float dt, float invDt, float backCalc, bool conditional) {
+    PIDSIM_NO_VECTORIZE_LOOP
+    for (size_t k = begin; k < end; k++) {
+        float e = errors[k];
+        float raw = s.p[k] * e + s.i[k] * s.accum[k] + s.d[k] * (e - s.back[k]) * invDt;
+        float o = std::min(std::max(raw, s.lo[k]), s.hi[k]);
+        float excess = o - raw;
+        bool windingUp = conditional & (e * excess < 0.0f);
+        s.accum[k] += ((windingUp ? 0.0f : e) + backCalc * excess) * dt;
+        s.back[k] = e;
+        out[k] = o;
+    }
+}
+
+}
+
+void PIDBank::add(float p_gain, float i_gain, float d_gain) {
+    P.push_back(p_gain);
+    I.push_back(i_gain);
+    D.push_back(d_gain);
+    e_accum.push_back(0.0f);
+    e_back.push_back(0.0f);
+    out_min.push_back(-INFINITY);
+    out_max.push_back(INFINITY);
+}
+
+void PIDBank::step(const float* errors, float dt, float* out) {
+    Streams s{P.data(), I.data(), D.data(), out_min.data(), out_max.data(), e_accum.data(), e_back.data()};
+    const size_t n = size();
+    const float invDt = 1.0f / dt;
+    size_t k = 0;
+
+    // max(lo, raw) and min(hi, .) with the bound first keep NaN like
+    // std::max/min do in the scalar loop.
+#if defined(__AVX__)
+    const __m256 dt8 = _mm256_set1_ps(dt);
+    const __m256 inv8 = _mm256_set1_ps(invDt);
+    const __m256 kb8 = _mm256_set1_ps(back_calc);
+    const __m256 cond8 = _mm256_castsi256_ps(_mm256_set1_epi32(conditional_integration ? -1 : 0));
+    const __m256 zero8 = _mm256_setzero_ps();
+    for (; k + 8 <= n; k += 8) {
+        __m256 e = _mm256_loadu_ps(errors + k);
+        __m256 accum = _mm256_loadu_ps(s.accum + k);
+        __m256 pi = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(s.p + k), e), _mm256_mul_ps(_mm256_loadu_ps(s.i + k), accum));
+        __m256 d = _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(s.d + k), _mm256_sub_ps(e, _mm256_loadu_ps(s.back + k))), inv8);
+        __m256 raw = _mm256_add_ps(pi, d);
+        __m256 o = _mm256_min_ps(_mm256_loadu_ps(s.hi + k), _mm256_max_ps(_mm256_loadu_ps(s.lo + k), raw));
+        __m256 excess = _mm256_sub_ps(o, raw);
+        __m256 windingUp = _mm256_and_ps(cond8, _mm256_cmp_ps(_mm256_mul_ps(e, excess), zero8, _CMP_LT_OQ));
+        __m256 integrand = _mm256_add_ps(_mm256_andnot_ps(windingUp, e), _mm256_mul_ps(kb8, excess));
+        _mm256_storeu_ps(s.accum + k, _mm256_add_ps(accum, _mm256_mul_ps(integrand, dt8)));
+        _mm256_storeu_ps(s.back + k, e);
+        _mm256_storeu_ps(out + k, o);
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128 dt4 = _mm_set1_ps(dt);
+    const __m128 inv4 = _mm_set1_ps(invDt);
+    const __m128 kb4 = _mm_set1_ps(back_calc);
+    const __m128 cond4 = _mm_castsi128_ps(_mm_set1_epi32(conditional_integration ? -1 : 0));
+    const __m128 zero4 = _mm_setzero_ps();
+    for (; k + 4 <= n; k += 4) {
+        __m128 e = _mm_loadu_ps(errors + k);
+        __m128 accum = _mm_loadu_ps(s.accum + k);
+        __m128 pi = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s.p + k), e), _mm_mul_ps(_mm_loadu_ps(s.i + k), accum));
+        __m128 d = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(s.d + k), _mm_sub_ps(e, _mm_loadu_ps(s.back + k))), inv4);
+        __m128 raw = _mm_add_ps(pi, d);
+        __m128 o = _mm_min_ps(_mm_loadu_ps(s.hi + k), _mm_max_ps(_mm_loadu_ps(s.lo + k), raw));
+        __m128 excess = _mm_sub_ps(o, raw);
+        __m128 windingUp = _mm_and_ps(cond4, _mm_cmplt_ps(_mm_mul_ps(e, excess), zero4));
+        __m128 integrand = _mm_add_ps(_mm_andnot_ps(windingUp, e), _mm_mul_ps(kb4, excess));
+        _mm_storeu_ps(s.accum + k, _mm_add_ps(accum, _mm_mul_ps(integrand, dt4)));
+        _mm_storeu_ps(s.back + k, e);
+        _mm_storeu_ps(out + k, o);
+    }
+#endif
+    StepRange(s, errors, out, k, n, dt, invDt, back_calc, conditional_integration);
+}
+
+void PIDBank::stepScalar(const float* errors, float dt, float* out) {
+    Streams s{P.data(), I.data(), D.data(), out_min.data(), out_max.data(), e_accum.data(), e_back.data()};
+    StepRange(s, errors, out, 0, size(), dt, 1.0f / dt, back_calc, conditional_integration);
+}
+
+const char* PIDBank::simdPath() {
+#if defined(__AVX__)
+    return "avx";
+#elif defined(__SSE2__)
+    return "sse";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,107 @@
+#include "profiler.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include "sim_thread.hpp"
+
+namespace {
+
+// How much of each new frame goes into the rolling averages.
+constexpr float kSmoothing = 0.05f;
+
+void WriteJsonString(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+}
+
+Profiler::Profiler(size_t maxEvents) : origin(SimClockNow()) {
+    events.reserve(maxEvents > 0 ? maxEvents : 1);
+}
+
+const char* Profiler::trackName(Track track) {
+    switch (track) {
+    case Cpu: return "render thread";
+    case GpuMap: return "GPU (map)";
+    case GpuView: return "GPU (robot view)";
+    case Sim: return "sim thread";
+    default: return "?";
+    }
+}
+
+void Profiler::beginFrame() {
+    double now = SimClockNow();
+    if (frameStart >= 0.0) {
+        float ms = (float)((now - frameStart) * 1000.0);
+        frameAverage += (ms - frameAverage) * kSmoothing;
+    }
+    frameStart = now;
+
+    for (Stage& s : stageList) {
+        s.lastMs = s.frameMs;
+        s.averageMs += (s.frameMs - s.averageMs) * kSmoothing;
+        s.frameMs = 0.0f;
+    }
+}
+
+void Profiler::record(Track track, const char* name, double start, double seconds) {
+    Event e{name, track, start, seconds};
+    if (events.size() < events.capacity()) {
+        events.push_back(e);
+    } else {
+        events[nextEvent] = e;
+        nextEvent = (nextEvent + 1) % events.size();
+        wrapped = true;
+    }
+
+    // A handful of stages, so a linear scan beats anything cleverer.
+    for (Stage& s : stageList) {
+        if (s.track == track && (s.name == name || strcmp(s.name, name) == 0)) {
+            s.frameMs += (float)(seconds * 1000.0);
+            return;
+        }
+    }
+    Stage s;
+    s.name = name;
+    s.track = track;
+    s.frameMs = (float)(seconds * 1000.0);
+    stageList.push_back(s);
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) const {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int t = 0; t < kTracks; t++) {
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", t ? ",\n" : "", t);
+        WriteJsonString(f, trackName((Track)t));
+        fprintf(f, "}}");
+    }
+
+    // Oldest first, so the viewer doesn't have to sort a wrapped ring.
+    size_t count = events.size();
+    size_t first = wrapped ? nextEvent : 0;
+    for (size_t i = 0; i < count; i++) {
+        const Event& e = events[(first + i) % count];
+        fprintf(f, ",\n{\"name\":");
+        WriteJsonString(f, e.name);
+        fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                (int)e.track, (e.start - origin) * 1e6, e.seconds * 1e6);
+    }
+    fprintf(f, "\n]}\n");
+
+    return fclose(f) == 0;
+}
+
+ProfileScope::ProfileScope(Profiler& p, const char* stageName)
+    : profiler(p), name(stageName), start(SimClockNow()) {}
+
+ProfileScope::~ProfileScope() {
+    profiler.record(Profiler::Cpu, name, start, SimClockNow() - start);
+}
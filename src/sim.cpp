@@ -0,0 +1,160 @@
+#include "sim.hpp"
+
+#include <cmath>
+#include <cstring>
+
+template <typename T>
+BasicSimulation<T>::BasicSimulation(const float moveGains[3], const float turnGains[3], float startX, float startY)
+    : robot(startX, startY),
+      pid_x(T(moveGains[0]), T(moveGains[1]), T(moveGains[2])),
+      pid_y(T(moveGains[0]), T(moveGains[1]), T(moveGains[2])),
+      pid_r(T(turnGains[0]), T(turnGains[1]), T(turnGains[2])),
+      vel_x(T{}, T{}, T{}), vel_y(T{}, T{}, T{}), vel_r(T{}, T{}, T{}) {}
+
+template <typename T>
+void BasicSimulation<T>::setGains(const float moveGains[3], const float turnGains[3]) {
+    pid_x.P = pid_y.P = T(moveGains[0]);
+    pid_x.I = pid_y.I = T(moveGains[1]);
+    pid_x.D = pid_y.D = T(moveGains[2]);
+    pid_r.P = T(turnGains[0]);
+    pid_r.I = T(turnGains[1]);
+    pid_r.D = T(turnGains[2]);
+}
+
+float wrapAngle(float a) {
+    // (float)M_PI rounds up, so this is |a| <= pi for every float.
+    if (std::fabs(a) < (float)M_PI) return a;
+    // Constant time however far the heading wound up, and inf/NaN come
+    // back NaN instead of looping forever. For one wrap the double
+    // subtraction is exact, same as the old loop's. Past ~1e9 rad the
+    // multiple of 2 pi stops being exact, so leave those to remainder.
+    double d = a;
+    if (std::fabs(d) > 1e9) return (float)std::remainder(d, 2.0 * M_PI);
+    return (float)(d - 2.0 * M_PI * std::nearbyint(d * (0.5 / M_PI)));
+}
+
+template <typename T>
+void BasicSimulation<T>::setCascade(const CascadeConfig& config) {
+    if (config.enabled != cascaded) {
+        for (BasicPID<T>* pid : {&vel_x, &vel_y, &vel_r}) pid->e_accum = pid->e_back = T{};
+        vref_x = vref_y = vref_r = T{};
+        accel_x = accel_y = accel_r = T{};
+        outer.countdown = inner.countdown = 0;
+        cascaded = config.enabled;
+    }
+    outer.setEvery(config.outerEvery);
+    inner.setEvery(config.innerEvery);
+
+    vel_x.P = vel_y.P = T(config.moveVelGains[0]);
+    vel_x.I = vel_y.I = T(config.moveVelGains[1]);
+    vel_x.D = vel_y.D = T(config.moveVelGains[2]);
+    vel_r.P = T(config.turnVelGains[0]);
+    vel_r.I = T(config.turnVelGains[1]);
+    vel_r.D = T(config.turnVelGains[2]);
+}
+
+template <typename T>
+void BasicSimulation<T>::setActuationDelay(int ticks) {
+    pending.assign(ticks > 0 ? ticks : 0, {0.0f, 0.0f, 0.0f});
+    pendingHead = 0;
+}
+
+template <typename T>
+void BasicSimulation<T>::actuate(float ax, float ay, float ar, float dt) {
+    if (!pending.empty()) {
+        std::array<float, 3> due = pending[pendingHead];
+        pending[pendingHead] = {ax, ay, ar};
+        pendingHead = (pendingHead + 1) % pending.size();
+        ax = due[0];
+        ay = due[1];
+        ar = due[2];
+    }
+    robot.updatePose(ax, ay, ar, dt);
+}
+
+template <typename T>
+SimError BasicSimulation<T>::step(float targetX, float targetY, float dt, SimTerms* terms, const Reference* ref) {
+    float dx = targetX - robot.x;
+    float dy = targetY - robot.y;
+    float targetAngle = atan2(dy, dx) - 1.5708f;
+    float dr = wrapAngle(targetAngle - robot.r);
+
+    if (cascaded) return stepCascaded(dx, dy, dr, dt, terms, ref);
+
+    // Into the controllers' type and back; no-ops for float.
+    T ex(ref ? ref->x - robot.x : dx), ey(ref ? ref->y - robot.y : dy), er(dr), tdt(dt);
+
+    if (terms) {
+        terms->x = pidTerms(pid_x, ex, tdt);
+        terms->y = pidTerms(pid_y, ey, tdt);
+        terms->r = pidTerms(pid_r, er, tdt);
+    }
+
+    float ax = (float)pid_x.calculate_error(ex, tdt);
+    float ay = (float)pid_y.calculate_error(ey, tdt);
+    if (ref) {
+        ax += ref->ffX;
+        ay += ref->ffY;
+    }
+    actuate(ax, ay, (float)pid_r.calculate_error(er, tdt), dt);
+
+    return {dx, dy, dr};
+}
+
+template <typename T>
+SimError BasicSimulation<T>::stepCascaded(float dx, float dy, float dr, float dt, SimTerms* terms, const Reference* ref) {
+    if (outer.due()) {
+        T ex(ref ? ref->x - robot.x : dx), ey(ref ? ref->y - robot.y : dy), er(dr), outerDt(dt * outer.every);
+        outerTerms.x = pidTerms(pid_x, ex, outerDt);
+        outerTerms.y = pidTerms(pid_y, ey, outerDt);
+        outerTerms.r = pidTerms(pid_r, er, outerDt);
+        vref_x = pid_x.calculate_error(ex, outerDt);
+        vref_y = pid_y.calculate_error(ey, outerDt);
+        vref_r = pid_r.calculate_error(er, outerDt);
+    }
+    if (terms) *terms = outerTerms;
+
+    if (inner.due()) {
+        // Verlet keeps last tick's pose, which is all the velocity we need.
+        T innerDt(dt * inner.every);
+        T vx((robot.x - robot.x_back) / dt);
+        T vy((robot.y - robot.y_back) / dt);
+        T vr((robot.r - robot.r_back) / dt);
+        // The profile's velocity rides on top of the outer loop's correction.
+        T sx = ref ? vref_x + T(ref->vx) : vref_x;
+        T sy = ref ? vref_y + T(ref->vy) : vref_y;
+        accel_x = vel_x.calculate_error(sx - vx, innerDt);
+        accel_y = vel_y.calculate_error(sy - vy, innerDt);
+        accel_r = vel_r.calculate_error(vref_r - vr, innerDt);
+    }
+
+    float ax = (float)accel_x, ay = (float)accel_y;
+    if (ref) {
+        ax += ref->ffX;
+        ay += ref->ffY;
+    }
+    actuate(ax, ay, (float)accel_r, dt);
+    return {dx, dy, dr};
+}
+
+template class BasicSimulation<float>;
+template class BasicSimulation<double>;
+template class BasicSimulation<Fixed>;
+
+const char* backendName(PIDBackend backend) {
+    switch (backend) {
+    case PIDBackend::Double: return "double";
+    case PIDBackend::Fixed: return "fixed";
+    default: return "float";
+    }
+}
+
+bool parseBackend(const char* name, PIDBackend& out) {
+    for (PIDBackend b : {PIDBackend::Float, PIDBackend::Double, PIDBackend::Fixed}) {
+        if (strcmp(name, backendName(b)) == 0) {
+            out = b;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,132 @@
+#include "sim_thread.hpp"
+
+#include <chrono>
+#include "fixed_step.hpp"
+
+double SimClockNow() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+namespace {
+
+SimSnapshot FirstSnapshot(const SimInput& initial) {
+    SimSnapshot first;
+    first.dt = initial.dt;
+    first.speed = initial.speed;
+    first.tickTime = SimClockNow();
+    return first;
+}
+
+void PushTelemetry(TelemetryRing& ring, const SimTerms& t, const SwerveDrive& robot) {
+    const float sample[telemetry::kChannels] = {
+        t.x.error, t.x.p, t.x.i, t.x.d, t.x.output,
+        t.y.error, t.y.p, t.y.i, t.y.d, t.y.output,
+        t.r.error, t.r.p, t.r.i, t.r.d, t.r.output,
+        robot.x, robot.y, robot.r,
+    };
+    ring.push(sample);
+}
+
+}
+
+SimThread::SimThread(const SimInput& initial, size_t telemetryCapacity)
+    : sim(initial.moveGains, initial.turnGains), telemetryRing(telemetryCapacity),
+      input(initial), output(FirstSnapshot(initial)) {}
+
+SimThread::~SimThread() {
+    stop();
+}
+
+bool SimThread::record(const std::string& path) {
+    return recorder.open(path, sim.robot.x, sim.robot.y);
+}
+
+void SimThread::start() {
+    if (running.exchange(true)) return;
+    thread = std::thread([this] { run(); });
+}
+
+void SimThread::stop() {
+    if (!running.exchange(false)) return;
+    thread.join();
+    recorder.close();
+}
+
+void SimThread::run() {
+    input.update();
+    FixedStepClock clock(input.readBuffer().dt);
+    uint64_t tick = 0;
+    double simTime = 0.0;
+    double last = SimClockNow();
+
+    while (running.load(std::memory_order_relaxed)) {
+        input.update();
+        const SimInput& in = input.readBuffer();
+        sim.setGains(in.moveGains, in.turnGains);
+        sim.setCascade(in.cascade);
+        follower.limits = in.profile;
+        if (recorder.isOpen()) {
+            recorder.cascade(in.cascade);
+            recorder.profile(in.profiled, in.profile);
+        }
+        clock.step = in.dt;
+
+        // Flat out there's no schedule to keep: run a batch, publish it, and
+        // drop whatever the clock had owed so going back to a paced speed
+        // doesn't start with a burst of catch-up.
+        bool flatOut = in.speed <= 0.0f;
+        double now = SimClockNow();
+        int steps = flatOut ? clock.maxStepsPerFrame : clock.advance((now - last) * in.speed);
+        if (flatOut) clock.accumulator = 0.0;
+        last = now;
+
+        if (steps > 0 && recorder.isOpen()) recorder.gains(in.moveGains, in.turnGains);
+
+        SimError error{0.0f, 0.0f, 0.0f};
+        SimTerms terms;
+        double batchStart = SimClockNow();
+        for (int i = 0; i < steps; i++) {
+            if (in.profiled) {
+                Reference ref = follower.next(in.targetX, in.targetY, sim.robot, in.dt);
+                error = sim.step(in.targetX, in.targetY, in.dt, &terms, &ref);
+            } else {
+                error = sim.step(in.targetX, in.targetY, in.dt, &terms);
+            }
+            PushTelemetry(telemetryRing, terms, sim.robot);
+            tick++;
+            simTime += in.dt;
+            if (recorder.isOpen()) {
+                recorder.tick({in.targetX, in.targetY, in.dt, sim.robot.x, sim.robot.y, sim.robot.r});
+            }
+            // Publish about once a millisecond so the renderer (and new
+            // input) keep up even when a batch has no natural end.
+            if (flatOut && (i & 63) == 63 && SimClockNow() - batchStart > 1e-3) {
+                steps = i + 1;
+            }
+        }
+
+        if (steps > 0) {
+            double batchEnd = SimClockNow();
+            SimSnapshot& out = output.writeBuffer();
+            out.robot = sim.robot;
+            out.pid_x = sim.pid_x;
+            out.pid_y = sim.pid_y;
+            out.pid_r = sim.pid_r;
+            out.error = error;
+            out.tick = tick;
+            out.dt = in.dt;
+            out.speed = in.speed;
+            out.simTime = simTime;
+            out.tickTime = flatOut ? batchEnd : now - clock.accumulator / in.speed;
+            out.batchStart = batchStart;
+            out.batchSeconds = batchEnd - batchStart;
+            out.batchTicks = steps;
+            output.publish();
+        }
+
+        // Sleep until the next tick is due.
+        if (!flatOut) {
+            std::this_thread::sleep_for(std::chrono::duration<double>((clock.step - clock.accumulator) / in.speed));
+        }
+    }
+}
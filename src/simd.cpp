@@ -0,0 +1,30 @@
+#include "simd.hpp"
+
+bool cpuHasAvx2() {
+#if PIDSIM_X86_DISPATCH
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+#else
+    return false;
+#endif
+}
+
+CoreBuild coreBuild() {
+    CoreBuild b{};
+#if defined(PIDSIM_NATIVE)
+    b.native = true;
+#endif
+#if defined(__SSE2__)
+    b.sse2 = true;
+#endif
+#if defined(__AVX__)
+    b.avx = true;
+#endif
+#if defined(__AVX2__)
+    b.avx2 = true;
+#endif
+#if defined(__FMA__)
+    b.fma = true;
+#endif
+    return b;
+}
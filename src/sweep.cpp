@@ -0,0 +1,175 @@
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include "sim.hpp"
+
+namespace {
+
+// Accumulates step-response scores for a single axis, one sample per tick.
+// `error` is what the controller saw, `progress` is how far along the way
+// to the target we are (0 at the start, 1 on target, >1 past it).
+class AxisTracker {
+private:
+    AxisMetrics m;
+    float initialError = 0.0f;
+    float band = 0.0f;
+    float t10 = -1.0f;
+    float maxProgress = 0.0f;
+    float lastOutside = 0.0f;
+    bool started = false;
+
+public:
+    explicit AxisTracker(float settleBand) : band(settleBand) {}
+
+    void add(float t, float dt, float error, float progress) {
+        float absError = std::fabs(error);
+        if (!started) {
+            initialError = absError;
+            started = true;
+        }
+
+        m.ise += error * error * dt;
+        m.iae += absError * dt;
+        m.itae += t * absError * dt;
+
+        maxProgress = std::max(maxProgress, progress);
+        if (t10 < 0.0f && progress >= 0.1f) t10 = t;
+        if (m.riseTime < 0.0f && progress >= 0.9f) m.riseTime = t - t10;
+
+        // Tiny initial errors still get a small absolute band to settle into.
+        float tolerance = std::max(band * initialError, 1e-4f);
+        if (absError > tolerance) lastOutside = t + dt;
+    }
+
+    AxisMetrics finish(float duration) {
+        m.overshoot = std::max(0.0f, maxProgress - 1.0f);
+        m.settlingTime = (lastOutside < duration) ? lastOutside : -1.0f;
+        if (initialError <= 1e-4f) {
+            m.overshoot = 0.0f;
+            m.riseTime = 0.0f;
+        }
+        return m;
+    }
+};
+
+template <typename T>
+RunResult evaluate(const Gains& gains, const Scenario& scenario) {
+    RunResult result;
+    result.gains = gains;
+
+    BasicSimulation<T> sim(gains.move, gains.turn, scenario.startX, scenario.startY);
+    sim.setCascade(scenario.cascade);
+    sim.setActuationDelay((int)std::lround(scenario.latency / scenario.dt));
+
+    // Whichever controllers output the acceleration get the limits. An
+    // infinite limit converts to Fixed's range, so it never binds there either.
+    bool cascaded = scenario.cascade.enabled;
+    BasicPID<T>& outX = cascaded ? sim.vel_x : sim.pid_x;
+    BasicPID<T>& outY = cascaded ? sim.vel_y : sim.pid_y;
+    BasicPID<T>& outR = cascaded ? sim.vel_r : sim.pid_r;
+    auto configure = [&](BasicPID<T>& pid, float limit) {
+        pid.setLimits(T(-limit), T(limit));
+        pid.back_calc = T(scenario.backCalculation);
+        pid.conditional_integration = scenario.conditionalIntegration;
+    };
+    configure(outX, scenario.moveLimit);
+    configure(outY, scenario.moveLimit);
+    configure(outR, scenario.turnLimit);
+    AxisTracker move(scenario.settleBand), turn(scenario.settleBand);
+    ProfileFollower follower;
+    follower.limits = scenario.profile;
+
+    float pathX = scenario.targetX - scenario.startX;
+    float pathY = scenario.targetY - scenario.startY;
+    float pathLen2 = pathX * pathX + pathY * pathY;
+    float initialTurn = 0.0f;
+
+    int steps = (int)std::lround(scenario.duration / scenario.dt);
+    for (int i = 0; i < steps; i++) {
+        float t = i * scenario.dt;
+        float relX = sim.robot.x - scenario.startX;
+        float relY = sim.robot.y - scenario.startY;
+
+        Reference ref;
+        if (scenario.profiled) ref = follower.next(scenario.targetX, scenario.targetY, sim.robot, scenario.dt);
+        SimError e = sim.step(scenario.targetX, scenario.targetY, scenario.dt, nullptr, scenario.profiled ? &ref : nullptr);
+        if (i == 0) initialTurn = e.dr;
+
+        float dist = std::sqrt(e.dx * e.dx + e.dy * e.dy);
+        float moveProgress = (pathLen2 > 0.0f) ? (relX * pathX + relY * pathY) / pathLen2 : 1.0f;
+        float turnProgress = (initialTurn != 0.0f) ? 1.0f - e.dr / initialTurn : 1.0f;
+        move.add(t, scenario.dt, dist, moveProgress);
+        turn.add(t, scenario.dt, e.dr, turnProgress);
+
+        // Written so NaN fails the test too.
+        float limit = scenario.divergeLimit;
+        bool bounded = std::fabs(sim.robot.x) < limit && std::fabs(sim.robot.y) < limit && std::fabs(sim.robot.r) < limit &&
+                       std::fabs((float)sim.pid_x.e_accum) < limit && std::fabs((float)sim.pid_y.e_accum) < limit &&
+                       std::fabs((float)sim.pid_r.e_accum) < limit && std::fabs((float)sim.vel_x.e_accum) < limit &&
+                       std::fabs((float)sim.vel_y.e_accum) < limit && std::fabs((float)sim.vel_r.e_accum) < limit;
+        if (!bounded) {
+            result.diverged = true;
+            break;
+        }
+        if (scenario.skipSaturated && (outX.saturated | outY.saturated | outR.saturated)) {
+            result.saturated = true;
+            break;
+        }
+    }
+
+    result.translation = move.finish(scenario.duration);
+    result.rotation = turn.finish(scenario.duration);
+    if (result.diverged || result.saturated) {
+        result.translation.settlingTime = result.rotation.settlingTime = -1.0f;
+    }
+    return result;
+}
+
+}
+
+RunResult evaluateGains(const Gains& gains, const Scenario& scenario) {
+    switch (scenario.backend) {
+    case PIDBackend::Double: return evaluate<double>(gains, scenario);
+    case PIDBackend::Fixed: return evaluate<Fixed>(gains, scenario);
+    default: return evaluate<float>(gains, scenario);
+    }
+}
+
+float runCost(const RunResult& result) {
+    return (result.diverged || result.saturated) ? INFINITY : result.translation.itae + result.rotation.itae;
+}
+
+std::vector<RunResult> runSweep(const std::vector<Gains>& candidates, const Scenario& scenario, ThreadPool& pool) {
+    std::vector<RunResult> results(candidates.size());
+    pool.parallelFor(candidates.size(), [&](size_t i) {
+        results[i] = evaluateGains(candidates[i], scenario);
+    });
+    return results;
+}
+
+std::vector<std::array<float, 3>> makeTripleGrid(const std::array<float, 3>& lo, const std::array<float, 3>& hi, const std::array<int, 3>& counts) {
+    auto at = [&](int axis, int i) {
+        if (counts[axis] <= 1) return lo[axis];
+        return lo[axis] + (hi[axis] - lo[axis]) * (float)i / (float)(counts[axis] - 1);
+    };
+
+    std::vector<std::array<float, 3>> triples;
+    triples.reserve((size_t)std::max(counts[0], 1) * std::max(counts[1], 1) * std::max(counts[2], 1));
+    for (int p = 0; p < std::max(counts[0], 1); p++)
+        for (int i = 0; i < std::max(counts[1], 1); i++)
+            for (int d = 0; d < std::max(counts[2], 1); d++)
+                triples.push_back({at(0, p), at(1, i), at(2, d)});
+    return triples;
+}
+
+std::vector<Gains> makeGainGrid(const std::vector<std::array<float, 3>>& move, const std::vector<std::array<float, 3>>& turn) {
+    std::vector<Gains> grid;
+    grid.reserve(move.size() * turn.size());
+    for (const auto& m : move) {
+        for (const auto& t : turn) {
+            grid.push_back({{m[0], m[1], m[2]}, {t[0], t[1], t[2]}});
+        }
+    }
+    return grid;
+}
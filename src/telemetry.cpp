@@ -0,0 +1,109 @@
+#include "telemetry.hpp"
+
+#include <algorithm>
+
+namespace telemetry {
+
+const char* channelName(int channel) {
+    static const char* const names[kChannels] = {
+        "x error", "x P", "x I", "x D", "x output",
+        "y error", "y P", "y I", "y D", "y output",
+        "r error", "r P", "r I", "r D", "r output",
+        "pose x", "pose y", "pose r",
+    };
+    return (channel >= 0 && channel < kChannels) ? names[channel] : "?";
+}
+
+}
+
+using telemetry::kChannels;
+
+namespace {
+
+std::unique_ptr<std::atomic<float>[]> ZeroedFloats(size_t n) {
+    // Value-initialized, so every slot starts at 0.
+    return std::unique_ptr<std::atomic<float>[]>(new std::atomic<float>[n]());
+}
+
+}
+
+TelemetryRing::TelemetryRing(size_t capacity) {
+    size = 16;
+    while (size < capacity) size <<= 1;
+    mask = size - 1;
+    raw = ZeroedFloats(kChannels * size);
+
+    for (int shift = telemetry::kFanoutShift; ((size_t)1 << shift) < size; shift += telemetry::kFanoutShift) {
+        // Twice the blocks the raw ring needs, so the block holding the oldest
+        // raw sample is never the one being refilled by the newest.
+        size_t blocks = (size >> shift) * 2;
+        levels.push_back({shift, blocks - 1, ZeroedFloats(kChannels * blocks), ZeroedFloats(kChannels * blocks)});
+    }
+}
+
+void TelemetryRing::push(const float sample[kChannels]) {
+    uint64_t n = head.load(std::memory_order_relaxed);
+
+    for (int c = 0; c < kChannels; c++) {
+        float v = sample[c];
+        raw[c * size + (n & mask)].store(v, std::memory_order_relaxed);
+
+        for (const Level& level : levels) {
+            size_t blocks = level.mask + 1;
+            size_t slot = c * blocks + ((n >> level.shift) & level.mask);
+            // First sample of a block resets it; the rest widen it.
+            if ((n & (((uint64_t)1 << level.shift) - 1)) == 0) {
+                level.lo[slot].store(v, std::memory_order_relaxed);
+                level.hi[slot].store(v, std::memory_order_relaxed);
+            } else {
+                level.lo[slot].store(std::min(level.lo[slot].load(std::memory_order_relaxed), v), std::memory_order_relaxed);
+                level.hi[slot].store(std::max(level.hi[slot].load(std::memory_order_relaxed), v), std::memory_order_relaxed);
+            }
+        }
+    }
+
+    head.store(n + 1, std::memory_order_release);
+}
+
+void TelemetryRing::range(int channel, uint64_t begin, uint64_t end, float& lo, float& hi) const {
+    uint64_t n = written();
+    uint64_t oldest = (n > size) ? n - size : 0;
+    begin = std::max(begin, oldest);
+    end = std::min(end, n);
+    if (begin >= end) {
+        lo = hi = 0.0f;
+        return;
+    }
+
+    // Biggest blocks that still fit in the span: at most kFanout + 1 of them
+    // after snapping, whatever the span length.
+    uint64_t span = end - begin;
+    const Level* best = nullptr;
+    for (const Level& level : levels) {
+        if (((uint64_t)1 << level.shift) > span) break;
+        best = &level;
+    }
+
+    if (!best) {
+        lo = hi = sample(channel, begin);
+        for (uint64_t i = begin + 1; i < end; i++) {
+            float v = sample(channel, i);
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+        return;
+    }
+
+    size_t blocks = best->mask + 1;
+    uint64_t first = begin >> best->shift;
+    uint64_t last = (end - 1) >> best->shift;
+
+    const std::atomic<float>* los = &best->lo[channel * blocks];
+    const std::atomic<float>* his = &best->hi[channel * blocks];
+    lo = los[first & best->mask].load(std::memory_order_relaxed);
+    hi = his[first & best->mask].load(std::memory_order_relaxed);
+    for (uint64_t b = first + 1; b <= last; b++) {
+        lo = std::min(lo, los[b & best->mask].load(std::memory_order_relaxed));
+        hi = std::max(hi, his[b & best->mask].load(std::memory_order_relaxed));
+    }
+}
@@ -0,0 +1,202 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "sim.hpp"
+
+namespace {
+
+// The format is little-endian whatever the host is. Building the bytes with
+// shifts instead of fwrite/memcpy of the raw values keeps it that way, and
+// compilers turn these back into plain stores and loads on little-endian
+// hosts, so x86 pays nothing for it.
+void PutU32(uint8_t* out, uint32_t bits) {
+    for (int i = 0; i < 4; i++) out[i] = (uint8_t)(bits >> (8 * i));
+}
+
+uint32_t GetU32(const uint8_t* at) {
+    return (uint32_t)at[0] | (uint32_t)at[1] << 8 | (uint32_t)at[2] << 16 | (uint32_t)at[3] << 24;
+}
+
+void EncodeFloats(uint8_t* out, const float* values, int count) {
+    for (int i = 0; i < count; i++) {
+        uint32_t bits;
+        memcpy(&bits, &values[i], sizeof(bits));
+        PutU32(out + 4 * i, bits);
+    }
+}
+
+void PutFloats(FILE* file, uint8_t tag, const float* values, int count) {
+    uint8_t bytes[1 + 9 * sizeof(float)]; // the longest record, 'C'
+    bytes[0] = tag;
+    EncodeFloats(bytes + 1, values, count);
+    fwrite(bytes, 1, 1 + count * sizeof(float), file);
+}
+
+void GetFloats(const uint8_t* at, float* values, int count) {
+    for (int i = 0; i < count; i++) {
+        uint32_t bits = GetU32(at + 4 * i);
+        memcpy(&values[i], &bits, sizeof(bits));
+    }
+}
+
+}
+
+bool TraceWriter::open(const std::string& path, float startX, float startY) {
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    // Big buffer so the sim thread rarely pays for a write syscall.
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    float start[2] = {startX, startY};
+    uint8_t header[trace::kHeaderSize];
+    memcpy(header, trace::kMagic, sizeof(trace::kMagic));
+    PutU32(header + sizeof(trace::kMagic), trace::kVersion);
+    EncodeFloats(header + sizeof(trace::kMagic) + sizeof(uint32_t), start, 2);
+    fwrite(header, 1, sizeof(header), file);
+    haveGains = haveCascade = haveProfile = false;
+    return true;
+}
+
+void TraceWriter::close() {
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+void TraceWriter::gains(const float move[3], const float turn[3]) {
+    float g[6] = {move[0], move[1], move[2], turn[0], turn[1], turn[2]};
+    if (haveGains && memcmp(g, lastGains, sizeof(g)) == 0) return;
+    memcpy(lastGains, g, sizeof(g));
+    haveGains = true;
+    PutFloats(file, trace::kGains, g, 6);
+}
+
+void TraceWriter::cascade(const CascadeConfig& config) {
+    const float* mv = config.moveVelGains;
+    const float* tv = config.turnVelGains;
+    float c[9] = {config.enabled ? 1.0f : 0.0f, (float)config.outerEvery, (float)config.innerEvery,
+                  mv[0], mv[1], mv[2], tv[0], tv[1], tv[2]};
+    if (haveCascade && memcmp(c, lastCascade, sizeof(c)) == 0) return;
+    memcpy(lastCascade, c, sizeof(c));
+    haveCascade = true;
+    PutFloats(file, trace::kCascade, c, 9);
+}
+
+void TraceWriter::profile(bool profiled, const ProfileLimits& limits) {
+    float p[4] = {profiled ? 1.0f : 0.0f, limits.maxVel, limits.maxAccel, limits.maxJerk};
+    if (haveProfile && memcmp(p, lastProfile, sizeof(p)) == 0) return;
+    memcpy(lastProfile, p, sizeof(p));
+    haveProfile = true;
+    PutFloats(file, trace::kProfile, p, 4);
+}
+
+void TraceWriter::tick(const TraceTick& t) {
+    float v[6] = {t.targetX, t.targetY, t.dt, t.x, t.y, t.r};
+    PutFloats(file, trace::kTick, v, 6);
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+
+    // Replay walks the file front to back once; let the kernel read ahead
+    // and drop pages behind us.
+    madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+    bytes = (const uint8_t*)p;
+    length = (size_t)st.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) {
+        munmap((void*)bytes, length);
+        bytes = nullptr;
+        length = 0;
+    }
+}
+
+ReplayResult replayTrace(const uint8_t* data, size_t size) {
+    ReplayResult result;
+    if (size < trace::kHeaderSize || memcmp(data, trace::kMagic, sizeof(trace::kMagic)) != 0) return result;
+
+    uint32_t version = GetU32(data + sizeof(trace::kMagic));
+    if (version < 1 || version > trace::kVersion) return result;
+
+    float start[2];
+    GetFloats(data + sizeof(trace::kMagic) + sizeof(version), start, 2);
+
+    const float zero[3] = {0.0f, 0.0f, 0.0f};
+    Simulation sim(zero, zero, start[0], start[1]);
+    ProfileFollower follower;
+    bool profiled = false;
+
+    size_t at = trace::kHeaderSize;
+    while (at < size) {
+        uint8_t tag = data[at];
+        if (tag == trace::kGains && at + trace::kGainsSize <= size) {
+            float g[6];
+            GetFloats(data + at + 1, g, 6);
+            sim.setGains(g, g + 3);
+            at += trace::kGainsSize;
+        } else if (tag == trace::kCascade && at + trace::kCascadeSize <= size) {
+            float c[9];
+            GetFloats(data + at + 1, c, 9);
+            CascadeConfig config;
+            config.enabled = c[0] != 0.0f;
+            config.outerEvery = (int)c[1];
+            config.innerEvery = (int)c[2];
+            std::copy(c + 3, c + 6, config.moveVelGains);
+            std::copy(c + 6, c + 9, config.turnVelGains);
+            sim.setCascade(config);
+            at += trace::kCascadeSize;
+        } else if (tag == trace::kProfile && at + trace::kProfileSize <= size) {
+            float p[4];
+            GetFloats(data + at + 1, p, 4);
+            profiled = p[0] != 0.0f;
+            follower.limits = {p[1], p[2], p[3]};
+            at += trace::kProfileSize;
+        } else if (tag == trace::kTick && at + trace::kTickSize <= size) {
+            float v[6];
+            GetFloats(data + at + 1, v, 6);
+            if (profiled) {
+                Reference ref = follower.next(v[0], v[1], sim.robot, v[2]);
+                sim.step(v[0], v[1], v[2], nullptr, &ref);
+            } else {
+                sim.step(v[0], v[1], v[2]);
+            }
+
+            float pose[3] = {sim.robot.x, sim.robot.y, sim.robot.r};
+            if (memcmp(pose, v + 3, sizeof(pose)) != 0) {
+                if (result.mismatches == 0) result.firstMismatch = result.ticks;
+                result.mismatches++;
+            }
+            result.ticks++;
+            result.simSeconds += v[2];
+            at += trace::kTickSize;
+        } else {
+            return result;
+        }
+    }
+
+    result.valid = true;
+    return result;
+}